@@ -0,0 +1,353 @@
+/*
+ * Host microbenchmarks for the RuckusServoWheels hot paths. Measures the
+ * per-call latency and heap use of shouldStop(), checkForEnd() and
+ * correctDrift() for every move type on two and four wheel instances, and of
+ * a getConfig()/setConfig() round trip. Servos are the ESP32Servo stand-in and
+ * the nav sensor is a mock reporting steady progress, so only the library's
+ * own work is measured. Results are written as JSON for comparing commits.
+ *
+ * Usage: ruckus_bench [--iterations N] [--output FILE]
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#include <RuckusServoWheels.h>
+#include <Storage.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+/// @brief Heap use of the whole process, counted by the operator new replacements below
+static std::atomic<unsigned long> heap_allocations {0};
+static std::atomic<unsigned long> heap_bytes {0};
+
+void* operator new(size_t size) {
+	heap_allocations++;
+	heap_bytes += size;
+	void* block = malloc(size > 0 ? size : 1);
+	if (block == nullptr) {
+		throw std::bad_alloc();
+	}
+	return block;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+	free(block);
+}
+
+void operator delete[](void* block) noexcept {
+	free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+	free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+	free(block);
+}
+
+/// @brief Nav sensor that reports steady progress and a constant drift, so moves end on the sensor and every correction path runs
+class MockNavSensor : public RoboRuckusSensor {
+	public:
+		MockNavSensor() : RoboRuckusSensor("MockNav") {
+			movementModes.forward = true;
+			movementModes.backward = true;
+			movementModes.turnLeft = true;
+			movementModes.turnRight = true;
+			driftModes.forward = true;
+			driftModes.backward = true;
+		}
+
+		void startMove(RuckusCommunicator::MoveTypes move) override {
+			current_move = move;
+			started = micros();
+		}
+
+		void endMove() override {
+			started = micros();
+		}
+
+		std::tuple<Direction, float> checkDistance() override {
+			float ms = (micros() - started) / 1000.0f;
+			switch (current_move) {
+				case RuckusCommunicator::TURNLEFT: return std::make_tuple(LEFT, ms * turnSpeed);
+				case RuckusCommunicator::TURNRIGHT: return std::make_tuple(RIGHT, ms * turnSpeed);
+				case RuckusCommunicator::BACKWARD: return std::make_tuple(BACKWARD, ms * linearSpeed);
+				default: return std::make_tuple(FORWARD, ms * linearSpeed);
+			}
+		}
+
+		std::tuple<Direction, float> checkDrift() override {
+			return std::make_tuple(LEFT, 2.0f);
+		}
+
+		/// @brief Progress reported per ms, mm and degrees, about what the simulated robot makes
+		static constexpr float linearSpeed = 0.24;
+		static constexpr float turnSpeed = 0.2;
+
+	private:
+		RuckusCommunicator::MoveTypes current_move = RuckusCommunicator::FORWARD;
+		unsigned long started = 0;
+};
+
+/// @brief Exposes the protected hot paths to the benchmark
+class BenchWheels : public RuckusServoWheels {
+	public:
+		using RuckusServoWheels::RuckusServoWheels;
+		using RuckusServoWheels::shouldStop;
+		using RuckusServoWheels::checkForEnd;
+		using RuckusServoWheels::correctDrift;
+		using RuckusServoWheels::endMove;
+
+		/// @brief True while a slide made from other moves is settling between phases, when checkForEnd() isn't used
+		bool settling() const { return compoundMove && (currentMoveState == START || currentMoveState >= SETTLE_LEFT); }
+};
+
+/// @brief Measurements of one function
+struct BenchResult {
+	int wheels;
+	const char* function;
+	const char* move;
+	unsigned long calls = 0;
+	double meanNs = 0;
+	unsigned long p50Ns = 0;
+	unsigned long p99Ns = 0;
+	unsigned long maxNs = 0;
+	double allocationsPerCall = 0;
+	double bytesPerCall = 0;
+};
+
+/// @brief Collects call timings and heap use, storage is reserved up front so recording doesn't allocate
+class Recorder {
+	public:
+		Recorder(unsigned long calls) { samples.reserve(calls); }
+
+		unsigned long count() const { return samples.size(); }
+
+		void begin() {
+			allocations = heap_allocations;
+			bytes = heap_bytes;
+			started = std::chrono::steady_clock::now();
+		}
+
+		void end() {
+			auto elapsed = std::chrono::steady_clock::now() - started;
+			total_allocations += heap_allocations - allocations;
+			total_bytes += heap_bytes - bytes;
+			samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		}
+
+		BenchResult result(int wheels, const char* function, const char* move) {
+			BenchResult r {wheels, function, move};
+			r.calls = samples.size();
+			if (r.calls == 0) {
+				return r;
+			}
+			double total = 0;
+			for (unsigned long sample : samples) {
+				total += sample;
+			}
+			r.meanNs = total / r.calls;
+			std::sort(samples.begin(), samples.end());
+			r.p50Ns = samples[r.calls / 2];
+			r.p99Ns = samples[std::min(r.calls - 1, r.calls * 99 / 100)];
+			r.maxNs = samples.back();
+			r.allocationsPerCall = (double)total_allocations / r.calls;
+			r.bytesPerCall = (double)total_bytes / r.calls;
+			return r;
+		}
+
+	private:
+		std::vector<unsigned long> samples;
+		unsigned long allocations = 0;
+		unsigned long bytes = 0;
+		unsigned long total_allocations = 0;
+		unsigned long total_bytes = 0;
+		std::chrono::steady_clock::time_point started;
+};
+
+/// @brief Print that discards its output, so streaming the config is measured without storing it
+class NullPrint : public Print {
+	public:
+		size_t write(uint8_t c) override { return 1; }
+		size_t write(const uint8_t* buffer, size_t size) override { return size; }
+		using Print::write;
+};
+
+/// @brief Virtual time between calls, one pass of the framework loop (us)
+static const uint32_t tickUs = 2000;
+
+static const RuckusCommunicator::MoveTypes moveTypes[] = {
+	RuckusCommunicator::FORWARD, RuckusCommunicator::BACKWARD, RuckusCommunicator::TURNLEFT,
+	RuckusCommunicator::TURNRIGHT, RuckusCommunicator::SLIDELEFT, RuckusCommunicator::SLIDERIGHT
+};
+
+static const char* moveName(RuckusCommunicator::MoveTypes move) {
+	switch (move) {
+		case RuckusCommunicator::TURNLEFT: return "TURNLEFT";
+		case RuckusCommunicator::TURNRIGHT: return "TURNRIGHT";
+		case RuckusCommunicator::FORWARD: return "FORWARD";
+		case RuckusCommunicator::BACKWARD: return "BACKWARD";
+		case RuckusCommunicator::SLIDELEFT: return "SLIDELEFT";
+		case RuckusCommunicator::SLIDERIGHT: return "SLIDERIGHT";
+	}
+	return "UNKNOWN";
+}
+
+/// @brief Creates wheels with a config matching the simulator's default robot
+static BenchWheels* makeWheels(int wheels) {
+	Storage::reset();
+	HostClock::reset();
+	BenchWheels* bot = wheels == 4 ? new BenchWheels("Wheels", 12, 13, 14, 15) : new BenchWheels("Wheels", 12, 13);
+	const char* config = R"({"navSensor":{"current":"MockNav"},"linearTime":1300,"linearDistance":300,"turnTime":450,"turnDistance":90,"driftBoost":20})";
+	if (!bot->begin() || !bot->setConfig(config, false)) {
+		fprintf(stderr, "Failed to configure benchmark wheels\n");
+		exit(1);
+	}
+	return bot;
+}
+
+/// @brief Times one of the move functions over many passes of the framework loop, restarting the move whenever it ends
+static BenchResult benchMove(int wheels, const char* function, RuckusCommunicator::MoveTypes move, unsigned long calls) {
+	BenchWheels* bot = makeWheels(wheels);
+	Recorder recorder(calls);
+	bool endCheck = !strcmp(function, "checkForEnd");
+	bool drift = !strcmp(function, "correctDrift");
+	bot->move(move, 1);
+	while (recorder.count() < calls) {
+		HostClock::advance(tickUs);
+		bool done;
+		if (endCheck) {
+			// checkForEnd() is only reached through shouldStop() while a slide settles, so those passes aren't timed
+			if (bot->settling()) {
+				done = bot->shouldStop();
+			} else {
+				recorder.begin();
+				bool ended = bot->checkForEnd();
+				recorder.end();
+				// Let shouldStop() act on the end, starting the next phase of a slide
+				done = ended && bot->shouldStop();
+			}
+		} else if (drift) {
+			recorder.begin();
+			bot->correctDrift();
+			recorder.end();
+			done = bot->shouldStop();
+		} else {
+			bot->correctDrift();
+			recorder.begin();
+			done = bot->shouldStop();
+			recorder.end();
+		}
+		if (done) {
+			bot->endMove();
+		}
+		if (done || !bot->isMoving()) {
+			bot->move(move, 1);
+		}
+	}
+	delete bot;
+	return recorder.result(wheels, function, moveName(move));
+}
+
+/// @brief Times getConfig() and setConfig() separately, and a full round trip
+static void benchConfig(int wheels, unsigned long calls, std::vector<BenchResult>& results) {
+	BenchWheels* bot = makeWheels(wheels);
+	Recorder get(calls), set(calls), print(calls), roundTrip(calls);
+	NullPrint printer;
+	for (unsigned long i = 0; i < calls; i++) {
+		get.begin();
+		String current = bot->getConfig();
+		get.end();
+
+		print.begin();
+		bot->getConfig(printer);
+		print.end();
+
+		set.begin();
+		bot->setConfig(current, false);
+		set.end();
+
+		roundTrip.begin();
+		bot->setConfig(bot->getConfig(), false);
+		roundTrip.end();
+	}
+	delete bot;
+	results.push_back(get.result(wheels, "getConfig", ""));
+	results.push_back(print.result(wheels, "getConfigPrint", ""));
+	results.push_back(set.result(wheels, "setConfig", ""));
+	results.push_back(roundTrip.result(wheels, "configRoundTrip", ""));
+}
+
+int main(int argc, char** argv) {
+	unsigned long iterations = 20000;
+	const char* outputPath = "benchmark.json";
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--iterations") && hasValue) {
+			iterations = strtoul(argv[++i], nullptr, 10);
+		} else if (!strcmp(argv[i], "--output") && hasValue) {
+			outputPath = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: ruckus_bench [--iterations N] [--output FILE]\n");
+			return 2;
+		}
+	}
+	if (iterations == 0) {
+		fprintf(stderr, "Iterations must be above zero\n");
+		return 2;
+	}
+
+	MockNavSensor sensor;
+	std::vector<BenchResult> results;
+	const char* functions[] = {"shouldStop", "checkForEnd", "correctDrift"};
+	for (int wheels : {2, 4}) {
+		for (const char* function : functions) {
+			for (RuckusCommunicator::MoveTypes move : moveTypes) {
+				results.push_back(benchMove(wheels, function, move, iterations));
+			}
+		}
+		// Config handling is far slower than a control tick, fewer calls give a stable mean
+		benchConfig(wheels, std::max(iterations / 20, 1UL), results);
+	}
+
+	printf("%-6s %-16s %-10s %9s %9s %9s %9s %9s %10s\n", "wheels", "function", "move", "mean_ns", "p50_ns", "p99_ns", "max_ns", "allocs", "bytes");
+	JsonDocument doc;
+	doc["iterations"] = iterations;
+	doc["tickUs"] = tickUs;
+	JsonArray entries = doc["results"].to<JsonArray>();
+	for (const BenchResult& r : results) {
+		printf("%-6d %-16s %-10s %9.1f %9lu %9lu %9lu %9.2f %10.1f\n", r.wheels, r.function, r.move, r.meanNs, r.p50Ns, r.p99Ns, r.maxNs, r.allocationsPerCall, r.bytesPerCall);
+		JsonObject entry = entries.add<JsonObject>();
+		entry["wheels"] = r.wheels;
+		entry["function"] = r.function;
+		entry["move"] = r.move;
+		entry["calls"] = r.calls;
+		entry["meanNs"] = r.meanNs;
+		entry["p50Ns"] = r.p50Ns;
+		entry["p99Ns"] = r.p99Ns;
+		entry["maxNs"] = r.maxNs;
+		entry["allocationsPerCall"] = r.allocationsPerCall;
+		entry["bytesPerCall"] = r.bytesPerCall;
+	}
+	String json;
+	serializeJson(doc, json);
+	FILE* file = fopen(outputPath, "w");
+	if (file == nullptr) {
+		fprintf(stderr, "Could not write %s\n", outputPath);
+		return 1;
+	}
+	fprintf(file, "%s\n", json.c_str());
+	fclose(file);
+	printf("results written to %s\n", outputPath);
+	return 0;
+}
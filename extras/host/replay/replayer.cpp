@@ -0,0 +1,327 @@
+/*
+ * Replays a move trace recorded by RuckusServoWheels (see getTrace()) on the
+ * virtual clock. The framework's calls are made again at their recorded
+ * times, a stand-in nav sensor returns the recorded readings, and the servo
+ * writes and move ends of the replay are diffed against the recording. The
+ * replay starts at the first move the trace holds from its start, with the
+ * config the wheels had then (ruckus_sim --trace saves it next to the trace).
+ *
+ * Usage: ruckus_replay TRACE [--config FILE] [--max-diffs N] [--tolerance US]
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#include <RuckusServoWheels.h>
+#include <Storage.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/// @brief Exposes the trace layout and move state to the replayer
+class ReplayWheels : public RuckusServoWheels {
+	public:
+		using RuckusServoWheels::RuckusServoWheels;
+		using RuckusServoWheels::traceRecord;
+		using RuckusServoWheels::traceHeader;
+		using RuckusServoWheels::traceMagic;
+		using RuckusServoWheels::traceVersion;
+		using RuckusServoWheels::TRACE_START;
+		using RuckusServoWheels::TRACE_QUEUE;
+		using RuckusServoWheels::TRACE_ABORT;
+		using RuckusServoWheels::TRACE_STOP;
+		using RuckusServoWheels::TRACE_TICK;
+		using RuckusServoWheels::TRACE_DISTANCE;
+		using RuckusServoWheels::TRACE_DRIFT;
+		using RuckusServoWheels::TRACE_SERVO;
+		using RuckusServoWheels::TRACE_END;
+		using RuckusServoWheels::endMove;
+
+		/// @brief True from the start of a move until its wheels are stopped
+		bool running() const { return move_running; }
+};
+
+typedef ReplayWheels::traceRecord TraceRecord;
+
+/// @brief Moves the virtual clock forward to a time, never back
+static void clockTo(uint64_t us) {
+	if (us > HostClock::now()) {
+		HostClock::advance(us - HostClock::now());
+	}
+}
+
+/// @brief Nav sensor returning the readings of a trace in order, each at the time it was recorded
+class TraceSensor : public RoboRuckusSensor {
+	public:
+		/// @param Name Sensor name the config assigns
+		/// @param Base Recorded time of the first move replayed
+		TraceSensor(String Name, uint32_t Base) : RoboRuckusSensor(Name), base(Base) {}
+
+		/// @brief Virtual time the first move is replayed at, setting up the wheels may already have moved the clock
+		uint64_t origin = 0;
+
+		/// @brief Virtual time a record is replayed at
+		uint64_t replayTime(const TraceRecord& record) const { return origin + (uint32_t)(record.time - base); }
+
+		/// @brief Sets the moves the sensor can measure from the bits of traceRecord::modes
+		void setModes(uint16_t modes) {
+			movementModes.forward = modes & 1;
+			movementModes.backward = modes & 2;
+			movementModes.turnLeft = modes & 4;
+			movementModes.turnRight = modes & 8;
+			driftModes.forward = modes & 16;
+			driftModes.backward = modes & 32;
+		}
+
+		std::tuple<Direction, float> checkDistance() override {
+			return next(distances, distance_index);
+		}
+
+		std::tuple<Direction, float> checkDrift() override {
+			return next(drifts, drift_index);
+		}
+
+		/// @brief Recorded readings
+		std::vector<TraceRecord> distances;
+		std::vector<TraceRecord> drifts;
+
+		/// @brief Readings the replay asked for past the end of the recording
+		unsigned long missing = 0;
+
+		/// @brief Readings recorded but never asked for
+		unsigned long unused() const { return distances.size() - distance_index + drifts.size() - drift_index; }
+
+	private:
+		std::tuple<Direction, float> next(const std::vector<TraceRecord>& readings, size_t& index) {
+			if (index >= readings.size()) {
+				missing++;
+				return std::make_tuple(FORWARD, 0.0f);
+			}
+			const TraceRecord& reading = readings[index++];
+			// The reading was recorded once the sensor returned, so the clock moves on by the time the sensor took
+			clockTo(replayTime(reading));
+			return std::make_tuple((Direction)reading.index, reading.value);
+		}
+
+		uint32_t base;
+		size_t distance_index = 0;
+		size_t drift_index = 0;
+};
+
+/// @brief Reads a trace written by getTrace()
+/// @return False if the file can't be read or isn't a trace of this version
+static bool loadTrace(const char* path, ReplayWheels::traceHeader& header, std::vector<TraceRecord>& records) {
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == ReplayWheels::traceMagic &&
+		header.version == ReplayWheels::traceVersion && header.recordSize == sizeof(TraceRecord);
+	if (valid) {
+		records.resize(header.recordCount);
+		valid = fread(records.data(), sizeof(TraceRecord), records.size(), file) == records.size();
+	}
+	fclose(file);
+	return valid;
+}
+
+/// @brief Reads a whole text file
+static bool readFile(const char* path, String& contents) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		return false;
+	}
+	char buffer[4096];
+	size_t count;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		contents.concat(buffer, count);
+	}
+	fclose(file);
+	return true;
+}
+
+/// @brief Index of the first move started in a trace, the records before it belong to a move the trace only holds the end of
+static size_t firstStart(const std::vector<TraceRecord>& records) {
+	for (size_t i = 0; i < records.size(); i++) {
+		if (records[i].event == ReplayWheels::TRACE_START) {
+			return i;
+		}
+	}
+	return records.size();
+}
+
+/// @brief The wheels' outputs from the first move started on, times relative to its start
+static std::vector<TraceRecord> outputs(const std::vector<TraceRecord>& records) {
+	std::vector<TraceRecord> result;
+	size_t start = firstStart(records);
+	for (size_t i = start; i < records.size(); i++) {
+		if (records[i].event == ReplayWheels::TRACE_SERVO || records[i].event == ReplayWheels::TRACE_END) {
+			result.push_back(records[i]);
+			result.back().time -= records[start].time;
+		}
+	}
+	return result;
+}
+
+static void printOutput(const char* label, const TraceRecord* record) {
+	if (record == nullptr) {
+		printf("  %-9s none\n", label);
+	} else if (record->event == ReplayWheels::TRACE_SERVO) {
+		printf("  %-9s %10.3fms servo %d %4.0fus\n", label, record->time / 1000.0, record->index, record->value);
+	} else {
+		printf("  %-9s %10.3fms end of move %d\n", label, record->time / 1000.0, record->index);
+	}
+}
+
+static void usage() {
+	fprintf(stderr, "Usage: ruckus_replay TRACE [--config FILE] [--max-diffs N] [--tolerance US]\n");
+	fprintf(stderr, "  --config is the wheels' config when the trace started, TRACE.json by default\n");
+	fprintf(stderr, "  --max-diffs limits the differences printed, --tolerance is how far apart in time matching outputs may be\n");
+}
+
+int main(int argc, char** argv) {
+	const char* tracePath = nullptr;
+	String configPath;
+	unsigned long maxDiffs = 10;
+	unsigned long tolerance = 0;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--config") && hasValue) {
+			configPath = argv[++i];
+		} else if (!strcmp(argv[i], "--max-diffs") && hasValue) {
+			maxDiffs = strtoul(argv[++i], nullptr, 10);
+		} else if (!strcmp(argv[i], "--tolerance") && hasValue) {
+			tolerance = strtoul(argv[++i], nullptr, 10);
+		} else if (argv[i][0] != '-' && tracePath == nullptr) {
+			tracePath = argv[i];
+		} else {
+			usage();
+			return 2;
+		}
+	}
+	if (tracePath == nullptr) {
+		usage();
+		return 2;
+	}
+	if (configPath.isEmpty()) {
+		configPath = String(tracePath) + ".json";
+	}
+
+	ReplayWheels::traceHeader header;
+	std::vector<TraceRecord> recorded;
+	if (!loadTrace(tracePath, header, recorded)) {
+		fprintf(stderr, "%s is not a move trace of version %u\n", tracePath, ReplayWheels::traceVersion);
+		return 1;
+	}
+	String config;
+	if (!readFile(configPath.c_str(), config)) {
+		fprintf(stderr, "Could not read %s\n", configPath.c_str());
+		return 1;
+	}
+	size_t start = firstStart(recorded);
+	if (start == recorded.size()) {
+		fprintf(stderr, "The trace holds no move start\n");
+		return 1;
+	}
+	uint32_t base = recorded[start].time;
+
+	// The sensor has to exist before the config assigns it
+	JsonDocument doc;
+	if (deserializeJson(doc, config)) {
+		fprintf(stderr, "Could not parse %s\n", configPath.c_str());
+		return 1;
+	}
+	TraceSensor sensor(doc["navSensor"]["current"] | "None", base);
+	for (size_t i = start; i < recorded.size(); i++) {
+		if (recorded[i].event == ReplayWheels::TRACE_DISTANCE) {
+			sensor.distances.push_back(recorded[i]);
+		} else if (recorded[i].event == ReplayWheels::TRACE_DRIFT) {
+			sensor.drifts.push_back(recorded[i]);
+		}
+	}
+
+	Logger.muted = true;
+	Storage::reset();
+	HostClock::reset();
+	std::unique_ptr<ReplayWheels> wheels(header.wheelCount == 4 ? new ReplayWheels("Wheels", 12, 13, 14, 15) : new ReplayWheels("Wheels", 12, 13));
+	ReplayWheels& bot = *wheels;
+	// Ticks are replayed from the trace, so they run from here rather than a control task
+	String replayConfig = String("{\"controlInterval\":0,\"traceRecords\":") + (unsigned long)(recorded.size() * 2 + 64) + "}";
+	if (!bot.begin() || !bot.setConfig(config, false) || !bot.setConfig(replayConfig, false)) {
+		fprintf(stderr, "Could not apply %s\n", configPath.c_str());
+		return 1;
+	}
+	bot.clearTrace();
+	sensor.origin = HostClock::now();
+
+	unsigned long ticks = 0;
+	double tickWall = 0;
+	for (size_t i = start; i < recorded.size(); i++) {
+		const TraceRecord& record = recorded[i];
+		uint64_t time = sensor.replayTime(record);
+		switch (record.event) {
+			case ReplayWheels::TRACE_START:
+				clockTo(time);
+				sensor.setModes(record.modes);
+				bot.move((RuckusCommunicator::MoveTypes)record.index, lround(record.value));
+				break;
+			case ReplayWheels::TRACE_QUEUE:
+				clockTo(time);
+				bot.queueMove((RuckusCommunicator::MoveTypes)record.index, lround(record.value));
+				break;
+			case ReplayWheels::TRACE_ABORT:
+				clockTo(time);
+				bot.abortMove();
+				break;
+			case ReplayWheels::TRACE_STOP:
+				// Moves that ended on their own were already stopped by the tick that ended them
+				clockTo(time);
+				if (bot.running()) {
+					bot.endMove();
+				}
+				break;
+			case ReplayWheels::TRACE_TICK: {
+				clockTo(time);
+				auto wallStart = std::chrono::steady_clock::now();
+				bot.update();
+				tickWall += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - wallStart).count();
+				ticks++;
+				break;
+			}
+		}
+	}
+
+	String replayTrace;
+	StringPrint output(replayTrace);
+	bot.getTrace(output);
+	std::vector<TraceRecord> replayed(replayTrace.length() > sizeof(header) ? (replayTrace.length() - sizeof(header)) / sizeof(TraceRecord) : 0);
+	if (!replayed.empty()) {
+		memcpy(replayed.data(), replayTrace.c_str() + sizeof(header), replayed.size() * sizeof(TraceRecord));
+	}
+	std::vector<TraceRecord> expected = outputs(recorded);
+	std::vector<TraceRecord> actual = outputs(replayed);
+
+	unsigned long differences = 0;
+	for (size_t i = 0; i < std::max(expected.size(), actual.size()); i++) {
+		const TraceRecord* a = i < expected.size() ? &expected[i] : nullptr;
+		const TraceRecord* b = i < actual.size() ? &actual[i] : nullptr;
+		bool same = a != nullptr && b != nullptr && a->event == b->event && a->index == b->index && a->value == b->value &&
+			(a->time > b->time ? a->time - b->time : b->time - a->time) <= tolerance;
+		if (same) {
+			continue;
+		}
+		if (differences++ < maxDiffs) {
+			printf("output %zu differs:\n", i);
+			printOutput("recorded", a);
+			printOutput("replayed", b);
+		}
+	}
+	if (differences > maxDiffs) {
+		printf("... %lu more differences\n", differences - maxDiffs);
+	}
+	printf("records=%zu ticks=%lu outputs recorded=%zu replayed=%zu differences=%lu\n", recorded.size() - start, ticks, expected.size(), actual.size(), differences);
+	printf("sensor readings unused=%lu missing=%lu\n", sensor.unused(), sensor.missing);
+	printf("replay wall time per tick %.2fus\n", ticks > 0 ? tickWall / ticks : 0);
+	return differences > 0 || sensor.unused() > 0 || sensor.missing > 0 ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+#include "RobotModel.h"
+#include <ESP32Servo.h>
+#include <cmath>
+
+RobotModel::RobotModel(const RobotParams& Params) : params(Params), rng(Params.seed), slip_noise(0, Params.slip) {}
+
+double RobotModel::targetSpeed(int wheel, int pulse) const {
+	if (pulse <= 0) {
+		return 0;
+	}
+	double offset = pulse - params.neutral[wheel];
+	if (std::fabs(offset) <= params.deadband) {
+		return 0;
+	}
+	offset -= std::copysign(params.deadband, offset);
+	double v = params.maxSpeed * params.gain[wheel] * std::tanh(offset / params.pulseScale);
+	// Right wheels are mirrored, so a shorter pulse drives them forward
+	return (wheel % 2 == 0) ? -v : v;
+}
+
+void RobotModel::step(uint32_t us) {
+	double dt = us / 1e6;
+	double alpha = 1 - std::exp(-dt / params.lag);
+	double right = 0, left = 0, lateral = 0;
+	int perSide = params.wheelCount / 2;
+	for (int i = 0; i < params.wheelCount; i++) {
+		double target = targetSpeed(i, Servo::pulseOnPin(params.pins[i]));
+		speed[i] += (target - speed[i]) * alpha;
+		double v = speed[i];
+		if (params.slip > 0) {
+			v *= 1 - slip_noise(rng);
+		}
+		if (i % 2 == 0) {
+			right += v;
+		} else {
+			left += v;
+		}
+		// Front right and rear left rollers push left when driven forward
+		lateral += (i == 0 || i == 3) ? v : -v;
+	}
+	right /= perSide;
+	left /= perSide;
+	double v = (right + left) / 2;
+	double w = (right - left) / params.trackWidth;
+	double side = 0;
+	if (params.mecanum && params.wheelCount == 4) {
+		w = (right - left) / (params.trackWidth + params.wheelBase);
+		side = lateral / 4;
+	}
+	double mid = current.theta + w * dt / 2;
+	current.x += (v * std::cos(mid) - side * std::sin(mid)) * dt;
+	current.y += (v * std::sin(mid) + side * std::cos(mid)) * dt;
+	current.theta += w * dt;
+}
+
+bool RobotModel::stationary(double threshold) const {
+	for (int i = 0; i < params.wheelCount; i++) {
+		if (std::fabs(speed[i]) > threshold) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,89 @@
+/*
+ * Differential-drive or mecanum physics for the host simulator. Wheel speeds follow the
+ * pulses last written to each servo pin through a saturating CR servo
+ * response with a deadband, per-wheel gain and a first-order lag.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <cstdint>
+#include <random>
+
+/// @brief Physical properties of a simulated robot
+struct RobotParams {
+	/// @brief Number of driven wheels (2 or 4)
+	int wheelCount = 2;
+
+	/// @brief Servo pins in config order: front right, front left, rear right, rear left
+	int pins[4] = {12, 13, 14, 15};
+
+	/// @brief Pulse (us) at which each wheel is truly stopped
+	float neutral[4] = {1472, 1472, 1472, 1472};
+
+	/// @brief Per-wheel speed multiplier, models servo mismatch
+	float gain[4] = {1, 1, 1, 1};
+
+	/// @brief Wheel surface speed at full deflection (mm/s)
+	float maxSpeed = 250;
+
+	/// @brief Pulse offset (us) over which the servo response saturates
+	float pulseScale = 300;
+
+	/// @brief Pulse offset (us) around neutral that produces no motion
+	float deadband = 15;
+
+	/// @brief Distance between left and right wheels (mm)
+	float trackWidth = 120;
+
+	/// @brief Four mecanum (or 45 degree omni) wheels, which can strafe, rather than a differential drive
+	bool mecanum = false;
+
+	/// @brief Distance between front and rear wheels (mm), only used by mecanum wheels
+	float wheelBase = 100;
+
+	/// @brief Wheel speed time constant (s)
+	float lag = 0.06f;
+
+	/// @brief Fraction of wheel speed randomly lost to slip on each step
+	float slip = 0;
+
+	/// @brief Seed for slip noise
+	uint32_t seed = 1;
+};
+
+/// @brief Position (mm) and heading (rad, counter-clockwise positive) of the robot
+struct Pose {
+	double x = 0;
+	double y = 0;
+	double theta = 0;
+};
+
+/// @brief Simulated robot body driven by the servo stand-ins
+class RobotModel {
+	public:
+		RobotModel(const RobotParams& Params);
+
+		/// @brief Integrates the model forward
+		/// @param us Microseconds to advance
+		void step(uint32_t us);
+
+		/// @brief Current pose
+		const Pose& pose() const { return current; }
+
+		/// @brief Current speed of a wheel (mm/s, positive drives the robot forward)
+		double wheelSpeed(int wheel) const { return speed[wheel]; }
+
+		/// @brief True when no wheel is moving faster than the given speed (mm/s)
+		bool stationary(double threshold = 1) const;
+
+		/// @brief Steady-state wheel speed for a pulse (mm/s, positive drives the robot forward)
+		double targetSpeed(int wheel, int pulse) const;
+
+		const RobotParams params;
+
+	private:
+		Pose current;
+		double speed[4] = {0, 0, 0, 0};
+		std::mt19937 rng;
+		std::uniform_real_distribution<double> slip_noise;
+};
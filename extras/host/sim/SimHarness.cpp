@@ -0,0 +1,231 @@
+#include "SimHarness.h"
+#include <cmath>
+
+SimHarness::SimHarness(const SimOptions& Options) : options(Options), robot(Options.robot), jitter(Options.robot.seed) {
+	HostClock::reset();
+	HostClock::setListener([this](uint32_t us) { robot.step(us); });
+	Storage::reset();
+	if (options.useSensor) {
+		nav.reset(new SimNavSensor("SimNav", robot, options.sensorNoise, options.robot.seed));
+		nav->latencyUs = options.sensorLatencyUs;
+	}
+	const int* pins = options.robot.pins;
+	if (options.robot.wheelCount == 4) {
+		bot.reset(new RuckusServoWheels("Wheels", pins[0], pins[1], pins[2], pins[3]));
+	} else {
+		bot.reset(new RuckusServoWheels("Wheels", pins[0], pins[1]));
+	}
+}
+
+SimHarness::~SimHarness() {
+	HostClock::setListener(nullptr);
+}
+
+bool SimHarness::begin() {
+	if (!bot->begin()) {
+		return false;
+	}
+	String config = options.config.isEmpty() ? defaultConfig(options) : options.config;
+	return bot->setConfig(config, true) && bot->flushConfig();
+}
+
+String SimHarness::defaultConfig(const SimOptions& options) {
+	JsonDocument doc;
+	doc["navSensor"]["current"] = options.useSensor ? "SimNav" : "None";
+	const char* prefixes[] = {"frontRight", "frontLeft", "rearRight", "rearLeft"};
+	for (int i = 0; i < options.robot.wheelCount; i++) {
+		String prefix = prefixes[i];
+		doc[prefix + "Pin"] = options.robot.pins[i];
+		doc[prefix + "Forward"] = i % 2 == 0 ? 699 : 2245;
+		doc[prefix + "Backward"] = i % 2 == 0 ? 2245 : 699;
+		doc[prefix + "Zero"] = 1472;
+		if (options.calibrate) {
+			// Steady state speeds, as a calibration run on the real robot would measure them
+			RobotModel model(options.robot);
+			const int offsets[] = {-800, -400, -200, -100, 0, 100, 200, 400, 800};
+			for (int j = 0; j < 9; j++) {
+				int pulse = 1472 + offsets[j];
+				doc[prefix + "Calibration"][j][0] = pulse;
+				doc[prefix + "Calibration"][j][1] = model.targetSpeed(i, pulse);
+			}
+		}
+	}
+	// The model turns counter-clockwise with its right wheels forward, the opposite of the firmware's left turn
+	doc["swapTurns"] = 1;
+	doc["servoMin"] = 544;
+	doc["servoMax"] = 2400;
+	doc["linearTime"] = 1300;
+	doc["linearDistance"] = options.squareSize;
+	doc["linearDrift"] = 1.0;
+	// Mecanum wheels turn the robot about a circle through all four wheels
+	doc["turnTime"] = options.robot.mecanum ? lround(450 * (options.robot.trackWidth + options.robot.wheelBase) / options.robot.trackWidth) : 450;
+	if (options.robot.mecanum) {
+		doc["wheelGeometry"] = 1;
+		doc["strafeTime"] = 1300;
+	}
+	doc["turnDistance"] = 90;
+	doc["turnDrift"] = 1.0;
+	for (const auto& setting : options.settings) {
+		if (setting.second == (long)setting.second) {
+			doc[setting.first] = (long)setting.second;
+		} else {
+			doc[setting.first] = setting.second;
+		}
+	}
+	String output;
+	serializeJson(doc, output);
+	return output;
+}
+
+MoveResult SimHarness::run(RuckusCommunicator::MoveTypes move, int magnitude) {
+	return runChained({{move, magnitude}});
+}
+
+MoveResult SimHarness::runChained(const std::vector<std::pair<RuckusCommunicator::MoveTypes, int>>& moves) {
+	MoveResult result;
+	if (moves.empty()) {
+		return result;
+	}
+	result.move = moves.front().first;
+	result.magnitude = moves.front().second;
+	if (nav && moves_run++ == options.sensorFailsAfter) {
+		// The sensor is still assigned, it just reports it can't measure anything, so moves fall back to time
+		nav->movementModes.forward = nav->movementModes.backward = false;
+		nav->movementModes.turnLeft = nav->movementModes.turnRight = false;
+		nav->driftModes.forward = nav->driftModes.backward = false;
+	}
+	Pose start = robot.pose();
+	Pose target = start;
+	for (const auto& entry : moves) {
+		target = expectedPose(target, entry.first, entry.second, options.squareSize);
+	}
+
+	auto wallStart = std::chrono::steady_clock::now();
+	uint64_t timeStart = HostClock::now();
+	unsigned long callsStart = nav ? nav->distanceCalls + nav->driftCalls : 0;
+	unsigned long writesStart = Servo::totalWrites();
+	bot->move(moves.front().first, moves.front().second);
+	for (size_t i = 1; i < moves.size(); i++) {
+		bot->queueMove(moves[i].first, moves[i].second);
+	}
+	bool done = false;
+	std::uniform_int_distribution<uint32_t> loopJitter(0, options.loopJitterUs);
+	while (!done) {
+		HostClock::advance(options.tickUs + loopJitter(jitter));
+		result.iterations++;
+		if (options.abortAfterMs > 0 && result.reportedProgress < 0 && HostClock::now() - timeStart >= options.abortAfterMs * 1000ULL) {
+			uint64_t abortStart = HostClock::now();
+			result.reportedProgress = bot->abortMove();
+			result.abortUs = HostClock::now() - abortStart;
+		}
+		done = bot->update();
+		if (!done && HostClock::now() - timeStart > moveTimeout * moves.size() * 1000ULL) {
+			result.timedOut = true;
+			break;
+		}
+	}
+	result.sensorCalls = nav ? nav->distanceCalls + nav->driftCalls - callsStart : 0;
+	result.servoWrites = Servo::totalWrites() - writesStart;
+	result = measure(start, target, timeStart, wallStart, result);
+	result.actualProgress = progress(start, robot.pose(), result.move, options.squareSize);
+	return result;
+}
+
+MoveResult SimHarness::measure(const Pose& start, const Pose& target, uint64_t timeStart, std::chrono::steady_clock::time_point wallStart, MoveResult result) {
+	result.virtualMs = (HostClock::now() - timeStart) / 1000;
+	result.wallUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - wallStart).count();
+
+	// Let the wheels spin down before measuring where the robot ended up
+	for (int i = 0; i < 500 && !robot.stationary(); i++) {
+		HostClock::advance(1000);
+	}
+
+	const Pose& end = robot.pose();
+	result.positionError = std::hypot(end.x - target.x, end.y - target.y);
+	result.headingError = std::remainder(end.theta - target.theta, 2 * M_PI) * 180 / M_PI;
+	return result;
+}
+
+double SimHarness::progress(const Pose& start, const Pose& end, RuckusCommunicator::MoveTypes move, float squareSize) {
+	double dx = end.x - start.x;
+	double dy = end.y - start.y;
+	double forward = dx * std::cos(start.theta) + dy * std::sin(start.theta);
+	double left = dy * std::cos(start.theta) - dx * std::sin(start.theta);
+	double turned = std::remainder(end.theta - start.theta, 2 * M_PI) / (M_PI / 2);
+	switch (move) {
+		case RuckusCommunicator::FORWARD: return forward / squareSize;
+		case RuckusCommunicator::BACKWARD: return -forward / squareSize;
+		case RuckusCommunicator::TURNLEFT: return turned;
+		case RuckusCommunicator::TURNRIGHT: return -turned;
+		case RuckusCommunicator::SLIDELEFT: return left / squareSize;
+		case RuckusCommunicator::SLIDERIGHT: return -left / squareSize;
+	}
+	return 0;
+}
+
+Pose SimHarness::expectedPose(const Pose& start, RuckusCommunicator::MoveTypes move, int magnitude, float squareSize) {
+	double dx = 0, dy = 0, dtheta = 0;
+	double square = squareSize * magnitude;
+	switch (move) {
+		case RuckusCommunicator::FORWARD: dx = square; break;
+		case RuckusCommunicator::BACKWARD: dx = -square; break;
+		case RuckusCommunicator::TURNLEFT: dtheta = M_PI / 2 * magnitude; break;
+		case RuckusCommunicator::TURNRIGHT: dtheta = -M_PI / 2 * magnitude; break;
+		case RuckusCommunicator::SLIDELEFT: dy = square; break;
+		case RuckusCommunicator::SLIDERIGHT: dy = -square; break;
+	}
+	Pose target;
+	target.x = start.x + dx * std::cos(start.theta) - dy * std::sin(start.theta);
+	target.y = start.y + dx * std::sin(start.theta) + dy * std::cos(start.theta);
+	target.theta = start.theta + dtheta;
+	return target;
+}
+
+const char* SimHarness::moveName(RuckusCommunicator::MoveTypes move) {
+	switch (move) {
+		case RuckusCommunicator::TURNLEFT: return "TURNLEFT";
+		case RuckusCommunicator::TURNRIGHT: return "TURNRIGHT";
+		case RuckusCommunicator::FORWARD: return "FORWARD";
+		case RuckusCommunicator::BACKWARD: return "BACKWARD";
+		case RuckusCommunicator::SLIDELEFT: return "SLIDELEFT";
+		case RuckusCommunicator::SLIDERIGHT: return "SLIDERIGHT";
+	}
+	return "UNKNOWN";
+}
+
+bool SimHarness::parseMoves(const String& list, std::vector<std::pair<RuckusCommunicator::MoveTypes, int>>& moves) {
+	unsigned int start = 0;
+	while (start < list.length()) {
+		int comma = list.indexOf(',', start);
+		String entry = list.substring(start, comma < 0 ? list.length() : comma);
+		entry.trim();
+		start = comma < 0 ? list.length() : comma + 1;
+		if (entry.isEmpty()) {
+			continue;
+		}
+		RuckusCommunicator::MoveTypes move;
+		unsigned int digits;
+		if (entry.startsWith("SL")) {
+			move = RuckusCommunicator::SLIDELEFT;
+			digits = 2;
+		} else if (entry.startsWith("SR")) {
+			move = RuckusCommunicator::SLIDERIGHT;
+			digits = 2;
+		} else {
+			digits = 1;
+			switch (entry[0]) {
+				case 'F': move = RuckusCommunicator::FORWARD; break;
+				case 'B': move = RuckusCommunicator::BACKWARD; break;
+				case 'L': move = RuckusCommunicator::TURNLEFT; break;
+				case 'R': move = RuckusCommunicator::TURNRIGHT; break;
+				default: return false;
+			}
+		}
+		int magnitude = entry.length() > digits ? entry.substring(digits).toInt() : 1;
+		if (magnitude <= 0) {
+			return false;
+		}
+		moves.push_back({move, magnitude});
+	}
+	return true;
+}
@@ -0,0 +1,135 @@
+/*
+ * Runs RuckusServoWheels against the robot model on the virtual clock and
+ * measures each move the way the framework would execute it.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <RuckusServoWheels.h>
+#include <chrono>
+#include <memory>
+#include <random>
+#include "RobotModel.h"
+#include "SimNavSensor.h"
+
+/// @brief Options for a simulated robot
+struct SimOptions {
+	/// @brief Physical robot
+	RobotParams robot;
+
+	/// @brief Assign a simulated nav sensor to the wheels
+	bool useSensor = true;
+
+	/// @brief Standard deviation of sensor noise
+	float sensorNoise = 0;
+
+	/// @brief Virtual time taken by each sensor reading (us)
+	uint32_t sensorLatencyUs = 0;
+
+	/// @brief Virtual time taken by one pass of the framework loop (us)
+	uint32_t tickUs = 2000;
+
+	/// @brief Most extra virtual time a pass of the framework loop may take, drawn at random for each pass (us), stands in for WiFi and other work sharing the loop
+	uint32_t loopJitterUs = 0;
+
+	/// @brief Aborts every move this long after it starts (ms), 0 to let moves finish
+	uint32_t abortAfterMs = 0;
+
+	/// @brief Number of moves after which the nav sensor stops reading any move, -1 for never
+	int sensorFailsAfter = -1;
+
+	/// @brief Length of one board square (mm)
+	float squareSize = 300;
+
+	/// @brief Config applied after begin(), empty for the simulator default
+	String config;
+
+	/// @brief Include wheel calibration tables measured from the robot model in the default config
+	bool calibrate = false;
+
+	/// @brief Numeric settings that override the default config, e.g. {"driftMode", 1}
+	std::vector<std::pair<String, double>> settings;
+};
+
+/// @brief Measurements of a single move
+struct MoveResult {
+	RuckusCommunicator::MoveTypes move;
+	int magnitude = 0;
+	/// @brief Virtual time from command to stop (ms)
+	unsigned long virtualMs = 0;
+	/// @brief Host time spent executing the move (us)
+	double wallUs = 0;
+	/// @brief Framework loop passes until the move ended
+	unsigned long iterations = 0;
+	/// @brief Nav sensor readings (checkDistance and checkDrift) taken during the move
+	unsigned long sensorCalls = 0;
+	/// @brief Servo writes that reached the (simulated) PWM peripheral during the move
+	unsigned long servoWrites = 0;
+	/// @brief Distance between final and ideal position (mm)
+	double positionError = 0;
+	/// @brief Difference between final and ideal heading (degrees)
+	double headingError = 0;
+	/// @brief True if the move never reported it was done
+	bool timedOut = false;
+	/// @brief Progress reported by abortMove() in units of magnitude, -1 if the move was not aborted
+	float reportedProgress = -1;
+	/// @brief Progress the robot made along the first move in units of magnitude, once it came to rest
+	double actualProgress = 0;
+	/// @brief Virtual time abortMove() took to return (us)
+	unsigned long abortUs = 0;
+};
+
+/// @brief A simulated robot running RuckusServoWheels
+class SimHarness {
+	public:
+		SimHarness(const SimOptions& Options);
+		~SimHarness();
+
+		/// @brief Starts the wheels and applies the config
+		/// @return True on success
+		bool begin();
+
+		/// @brief Executes one move to completion and lets the robot come to rest
+		/// @param move The move type
+		/// @param magnitude The move magnitude
+		/// @return Measurements for the move
+		MoveResult run(RuckusCommunicator::MoveTypes move, int magnitude);
+
+		/// @brief Executes a list of moves as one chain, queueing every move after the first
+		/// @param moves The moves and magnitudes to run
+		/// @return Measurements for the whole chain, error is against the pose the full sequence should reach
+		MoveResult runChained(const std::vector<std::pair<RuckusCommunicator::MoveTypes, int>>& moves);
+
+		/// @brief Progress made along a move between two poses in units of magnitude, squares or quarter turns
+		static double progress(const Pose& start, const Pose& end, RuckusCommunicator::MoveTypes move, float squareSize);
+
+		/// @brief Pose a move should reach from a starting pose
+		static Pose expectedPose(const Pose& start, RuckusCommunicator::MoveTypes move, int magnitude, float squareSize);
+
+		/// @brief Config matching the simulated robot
+		static String defaultConfig(const SimOptions& options);
+
+		/// @brief Name of a move type
+		static const char* moveName(RuckusCommunicator::MoveTypes move);
+
+		/// @brief Parses a move list such as "F2,L1,SR1"
+		/// @return False if an entry could not be parsed
+		static bool parseMoves(const String& list, std::vector<std::pair<RuckusCommunicator::MoveTypes, int>>& moves);
+
+		RuckusServoWheels& wheels() { return *bot; }
+		RobotModel& model() { return robot; }
+		SimNavSensor* sensor() { return nav.get(); }
+		const SimOptions options;
+
+		/// @brief Longest a move may take before it is abandoned (ms)
+		static constexpr unsigned long moveTimeout = 20000;
+
+	private:
+		MoveResult measure(const Pose& start, const Pose& target, uint64_t timeStart, std::chrono::steady_clock::time_point wallStart, MoveResult result);
+
+		RobotModel robot;
+		std::unique_ptr<SimNavSensor> nav;
+		std::unique_ptr<RuckusServoWheels> bot;
+		std::mt19937 jitter;
+		int moves_run = 0;
+};
@@ -0,0 +1,53 @@
+#include "SimNavSensor.h"
+#include <cmath>
+
+SimNavSensor::SimNavSensor(String Name, const RobotModel& Model, float Noise, uint32_t Seed) : RoboRuckusSensor(Name), model(Model), rng(Seed), noise(0, Noise > 0 ? Noise : 1), noise_sd(Noise) {
+	movementModes.forward = true;
+	movementModes.backward = true;
+	movementModes.turnLeft = true;
+	movementModes.turnRight = true;
+	driftModes.forward = true;
+	driftModes.backward = true;
+}
+
+float SimNavSensor::jitter() {
+	return noise_sd > 0 ? noise(rng) : 0;
+}
+
+void SimNavSensor::transact() {
+	if (latencyUs > 0) {
+		HostClock::advance(latencyUs);
+	}
+}
+
+void SimNavSensor::startMove(RuckusCommunicator::MoveTypes move) {
+	current_move = move;
+	start = model.pose();
+}
+
+void SimNavSensor::endMove() {
+	start = model.pose();
+}
+
+std::tuple<RoboRuckusSensor::Direction, float> SimNavSensor::checkDistance() {
+	distanceCalls++;
+	transact();
+	const Pose& now = model.pose();
+	double dx = now.x - start.x;
+	double dy = now.y - start.y;
+	double along = dx * std::cos(start.theta) + dy * std::sin(start.theta);
+	double turned = (now.theta - start.theta) * 180 / M_PI;
+	if (current_move == RuckusCommunicator::TURNLEFT || current_move == RuckusCommunicator::TURNRIGHT) {
+		float degrees = std::fabs(turned) + jitter();
+		return {turned >= 0 ? LEFT : RIGHT, degrees};
+	}
+	float distance = std::fabs(along) + jitter();
+	return {along >= 0 ? FORWARD : BACKWARD, distance};
+}
+
+std::tuple<RoboRuckusSensor::Direction, float> SimNavSensor::checkDrift() {
+	driftCalls++;
+	transact();
+	double turned = (model.pose().theta - start.theta) * 180 / M_PI + jitter();
+	return {turned >= 0 ? LEFT : RIGHT, static_cast<float>(std::fabs(turned))};
+}
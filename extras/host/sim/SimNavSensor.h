@@ -0,0 +1,44 @@
+/*
+ * Navigation sensor for the host simulator. Reports distance travelled and
+ * drift relative to the pose at the start of each move, read straight from
+ * the physics model with optional Gaussian noise.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <RoboRuckusSensor.h>
+#include "RobotModel.h"
+
+/// @brief Simulated RoboRuckus navigation sensor
+class SimNavSensor : public RoboRuckusSensor {
+	public:
+		/// @param Name Sensor name used for assignment
+		/// @param Model The robot to measure
+		/// @param Noise Standard deviation of reading noise (mm or degrees)
+		SimNavSensor(String Name, const RobotModel& Model, float Noise = 0, uint32_t Seed = 1);
+
+		void startMove(RuckusCommunicator::MoveTypes move) override;
+		void endMove() override;
+		std::tuple<Direction, float> checkDistance() override;
+		std::tuple<Direction, float> checkDrift() override;
+
+		/// @brief Number of checkDistance() calls made
+		unsigned long distanceCalls = 0;
+
+		/// @brief Number of checkDrift() calls made
+		unsigned long driftCalls = 0;
+
+		/// @brief Virtual time each reading takes, as a bus transaction would (us)
+		uint32_t latencyUs = 0;
+
+	private:
+		const RobotModel& model;
+		Pose start;
+		RuckusCommunicator::MoveTypes current_move = RuckusCommunicator::FORWARD;
+		std::mt19937 rng;
+		std::normal_distribution<float> noise;
+		float noise_sd;
+
+		float jitter();
+		void transact();
+};
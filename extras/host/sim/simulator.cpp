@@ -0,0 +1,242 @@
+/*
+ * Host simulator for RuckusServoWheels. Runs a sequence of moves on a
+ * simulated differential-drive robot and reports, per move, the virtual move
+ * time, host wall time, framework loop passes and final pose error.
+ *
+ * Usage: ruckus_sim [--wheels 2|4] [--sensor nav|none] [--noise SD]
+ *                   [--tick-us US] [--moves F2,L1,R1,B1,SL1,SR1] [--csv]
+ *                   [--asymmetry FRACTION] [--set key=value ...] [--chain]
+ *                   [--sensor-latency US] [--telemetry] [--calibrate]
+ *                   [--zero-error US] [--auto-calibrate] [--mecanum]
+ *                   [--loop-jitter US] [--abort-after MS] [--sag FRACTION]
+ *                   [--sensor-fails-after N] [--trace FILE] [--odometry]
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include "SimHarness.h"
+
+static void usage() {
+	fprintf(stderr, "Usage: ruckus_sim [--wheels 2|4] [--sensor nav|none] [--noise SD] [--tick-us US] [--moves LIST] [--csv]\n");
+	fprintf(stderr, "                  [--asymmetry FRACTION] [--set key=value ...] [--chain] [--sensor-latency US] [--telemetry] [--calibrate]\n");
+	fprintf(stderr, "                  [--zero-error US] [--auto-calibrate] [--mecanum] [--loop-jitter US] [--abort-after MS]\n");
+	fprintf(stderr, "                  [--sag FRACTION] [--sensor-fails-after N] [--trace FILE] [--odometry]\n");
+	fprintf(stderr, "  LIST is comma separated: F<n> forward, B<n> backward, L<n>/R<n> turns, SL<n>/SR<n> slides\n");
+	fprintf(stderr, "  --asymmetry slows the left wheels by FRACTION, --set overrides a numeric config setting\n");
+	fprintf(stderr, "  --sensor-latency adds virtual time to every sensor reading, like a bus transaction\n");
+	fprintf(stderr, "  --loop-jitter adds up to US of random virtual time to every pass of the framework loop\n");
+	fprintf(stderr, "  --abort-after aborts every move MS after it starts and compares the progress it reports with the robot's\n");
+	fprintf(stderr, "  --sag slows every wheel by FRACTION, as a drained battery would\n");
+	fprintf(stderr, "  --sensor-fails-after leaves the nav sensor unable to read any move after the first N moves\n");
+	fprintf(stderr, "  --chain queues the whole list as one move and reports it as a single row\n");
+	fprintf(stderr, "  --calibrate gives the wheels calibration tables measured from the simulated robot\n");
+	fprintf(stderr, "  --zero-error moves the true zero of the right wheels up and the left wheels down by US\n");
+	fprintf(stderr, "  --auto-calibrate runs the wheels' sensor calibration before the moves and prints the settings it chose\n");
+	fprintf(stderr, "  --mecanum fits four mecanum wheels, so slides strafe\n");
+	fprintf(stderr, "  --telemetry prints the wheels' move telemetry JSON after the run\n");
+	fprintf(stderr, "  --odometry prints the pose the wheels estimated over the moves next to the robot's\n");
+	fprintf(stderr, "  --trace writes the wheels' move trace to FILE and their config before the moves to FILE.json, for ruckus_replay\n");
+}
+
+int main(int argc, char** argv) {
+	SimOptions options;
+	String moveList = "F1,F2,B1,L1,R1,SL1,SR1";
+	bool csv = false;
+	bool chain = false;
+	bool telemetry = false;
+	bool autoCalibrate = false;
+	bool odometry = false;
+	const char* tracePath = nullptr;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--wheels") && hasValue) {
+			options.robot.wheelCount = atoi(argv[++i]) == 4 ? 4 : 2;
+		} else if (!strcmp(argv[i], "--sensor") && hasValue) {
+			options.useSensor = strcmp(argv[++i], "none") != 0;
+		} else if (!strcmp(argv[i], "--noise") && hasValue) {
+			options.sensorNoise = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--sensor-latency") && hasValue) {
+			options.sensorLatencyUs = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--loop-jitter") && hasValue) {
+			options.loopJitterUs = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--abort-after") && hasValue) {
+			options.abortAfterMs = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--sag") && hasValue) {
+			float sag = atof(argv[++i]);
+			for (int j = 0; j < 4; j++) {
+				options.robot.gain[j] *= 1 - sag;
+			}
+		} else if (!strcmp(argv[i], "--sensor-fails-after") && hasValue) {
+			options.sensorFailsAfter = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--trace") && hasValue) {
+			tracePath = argv[++i];
+			// Room for every pass of a long move list
+			options.settings.push_back({"traceRecords", 65536});
+		} else if (!strcmp(argv[i], "--tick-us") && hasValue) {
+			options.tickUs = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--moves") && hasValue) {
+			moveList = argv[++i];
+		} else if (!strcmp(argv[i], "--asymmetry") && hasValue) {
+			float asymmetry = atof(argv[++i]);
+			options.robot.gain[1] *= 1 - asymmetry;
+			options.robot.gain[3] *= 1 - asymmetry;
+		} else if (!strcmp(argv[i], "--set") && hasValue) {
+			String setting = argv[++i];
+			int equals = setting.indexOf('=');
+			if (equals <= 0) {
+				usage();
+				return 2;
+			}
+			options.settings.push_back({setting.substring(0, equals), atof(setting.substring(equals + 1).c_str())});
+		} else if (!strcmp(argv[i], "--zero-error") && hasValue) {
+			float error = atof(argv[++i]);
+			for (int j = 0; j < 4; j++) {
+				options.robot.neutral[j] += j % 2 == 0 ? error : -error;
+			}
+		} else if (!strcmp(argv[i], "--mecanum")) {
+			options.robot.mecanum = true;
+			options.robot.wheelCount = 4;
+		} else if (!strcmp(argv[i], "--auto-calibrate")) {
+			autoCalibrate = true;
+		} else if (!strcmp(argv[i], "--calibrate")) {
+			options.calibrate = true;
+		} else if (!strcmp(argv[i], "--odometry")) {
+			odometry = true;
+		} else if (!strcmp(argv[i], "--telemetry")) {
+			telemetry = true;
+		} else if (!strcmp(argv[i], "--chain")) {
+			chain = true;
+		} else if (!strcmp(argv[i], "--csv")) {
+			csv = true;
+		} else {
+			usage();
+			return 2;
+		}
+	}
+	std::vector<std::pair<RuckusCommunicator::MoveTypes, int>> moves;
+	if (!SimHarness::parseMoves(moveList, moves) || options.tickUs == 0) {
+		usage();
+		return 2;
+	}
+
+	SimHarness sim(options);
+	if (!sim.begin()) {
+		fprintf(stderr, "Failed to configure simulated wheels\n");
+		return 1;
+	}
+	if (autoCalibrate) {
+		uint64_t started = HostClock::now();
+		// The loop steps the calibration as it would on the robot
+		bool calibrating = sim.wheels().calibrate();
+		while (calibrating && sim.wheels().updateCalibration()) {
+			HostClock::advance(options.tickUs);
+		}
+		JsonDocument status;
+		deserializeJson(status, sim.wheels().getCalibration());
+		if (status["stage"].as<String>() != "saved") {
+			fprintf(stderr, "Calibration failed\n");
+			return 1;
+		}
+		// Settings chosen by the calibration, without the limits table
+		JsonDocument config;
+		deserializeJson(config, sim.wheels().getConfig());
+		JsonDocument chosen;
+		for (JsonPair setting : config.as<JsonObject>()) {
+			String key = setting.key().c_str();
+			if (key.endsWith("Forward") || key.endsWith("Backward") || key.endsWith("Zero") || key == "linearTime" || key == "turnTime") {
+				chosen[key] = setting.value();
+			}
+		}
+		String output;
+		serializeJson(chosen, output);
+		fprintf(csv ? stderr : stdout, "calibration %.1fs %s\n", (HostClock::now() - started) / 1e6, output.c_str());
+	}
+
+	// The trace replays from the config the moves started with, as learning changes it during them
+	String traceConfig;
+	if (tracePath != nullptr) {
+		traceConfig = sim.wheels().getConfig();
+		sim.wheels().clearTrace();
+	}
+
+	// Both poses are taken relative to where the moves start
+	Pose start = sim.model().pose();
+	sim.wheels().resetOdometry();
+
+	if (csv) {
+		printf("move,magnitude,virtual_ms,wall_us,iterations,sensor_calls,servo_writes,position_error_mm,heading_error_deg,timed_out\n");
+	} else {
+		printf("wheels=%d sensor=%s noise=%.2f tick=%uus\n", options.robot.wheelCount, options.useSensor ? "nav" : "none", options.sensorNoise, options.tickUs);
+		printf("%-10s %4s %9s %9s %7s %7s %7s %11s %12s\n", "move", "mag", "time_ms", "wall_us", "iters", "reads", "writes", "pos_err_mm", "head_err_deg");
+	}
+	unsigned long totalMs = 0;
+	double totalWall = 0;
+	unsigned long totalIterations = 0;
+	unsigned long totalReads = 0;
+	unsigned long totalWrites = 0;
+	double worstPosition = 0, worstHeading = 0;
+	int failures = 0;
+	std::vector<MoveResult> results;
+	if (chain) {
+		results.push_back(sim.runChained(moves));
+	} else {
+		for (const auto& entry : moves) {
+			results.push_back(sim.run(entry.first, entry.second));
+		}
+	}
+	for (const MoveResult& r : results) {
+		totalMs += r.virtualMs;
+		totalWall += r.wallUs;
+		totalIterations += r.iterations;
+		totalReads += r.sensorCalls;
+		totalWrites += r.servoWrites;
+		worstPosition = std::fmax(worstPosition, r.positionError);
+		worstHeading = std::fmax(worstHeading, std::fabs(r.headingError));
+		failures += r.timedOut ? 1 : 0;
+		if (csv) {
+			printf("%s,%d,%lu,%.1f,%lu,%lu,%lu,%.2f,%.2f,%d\n", chain ? "CHAIN" : SimHarness::moveName(r.move), chain ? (int)moves.size() : r.magnitude, r.virtualMs, r.wallUs, r.iterations, r.sensorCalls, r.servoWrites, r.positionError, r.headingError, r.timedOut ? 1 : 0);
+		} else {
+			printf("%-10s %4d %9lu %9.1f %7lu %7lu %7lu %11.1f %12.2f%s\n", chain ? "CHAIN" : SimHarness::moveName(r.move), chain ? (int)moves.size() : r.magnitude, r.virtualMs, r.wallUs, r.iterations, r.sensorCalls, r.servoWrites, r.positionError, r.headingError, r.timedOut ? "  TIMEOUT" : "");
+			if (r.reportedProgress >= 0) {
+				printf("  aborted in %.1fms: reported progress %.2f, robot came to rest at %.2f\n", r.abortUs / 1000.0, r.reportedProgress, r.actualProgress);
+			}
+		}
+	}
+	if (!csv) {
+		printf("%-10s %4s %9lu %9.1f %7lu %7lu %7lu %11.1f %12.2f\n", "total/worst", "", totalMs, totalWall, totalIterations, totalReads, totalWrites, worstPosition, worstHeading);
+		printf("diagnostics %s\n", sim.wheels().getDiagnostics().c_str());
+	}
+	if (odometry) {
+		const Pose& end = sim.model().pose();
+		double dx = end.x - start.x, dy = end.y - start.y;
+		printf("odometry %s robot {\"x\":%.1f,\"y\":%.1f,\"heading\":%.2f}\n", sim.wheels().getOdometry().c_str(), dx * cos(start.theta) + dy * sin(start.theta),
+			dy * cos(start.theta) - dx * sin(start.theta), (end.theta - start.theta) * 180 / M_PI);
+	}
+	if (telemetry) {
+		printf("%s\n", sim.wheels().getTelemetry().c_str());
+	}
+	if (tracePath != nullptr) {
+		String trace;
+		StringPrint output(trace);
+		sim.wheels().getTrace(output);
+		String configPath = String(tracePath) + ".json";
+		FILE* traceFile = fopen(tracePath, "wb");
+		FILE* configFile = fopen(configPath.c_str(), "w");
+		bool written = traceFile != nullptr && configFile != nullptr && fwrite(trace.c_str(), 1, trace.length(), traceFile) == trace.length() &&
+			fputs(traceConfig.c_str(), configFile) >= 0;
+		if (traceFile != nullptr) {
+			fclose(traceFile);
+		}
+		if (configFile != nullptr) {
+			fclose(configFile);
+		}
+		if (!written) {
+			fprintf(stderr, "Could not write %s\n", tracePath);
+			return 1;
+		}
+	}
+	return failures > 0 ? 1 : 0;
+}
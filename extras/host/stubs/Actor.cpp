@@ -0,0 +1,18 @@
+#include <Actor.h>
+#include <cstdio>
+
+HostLogger Logger;
+
+size_t HostLogger::write(uint8_t c) {
+	if (!muted) {
+		fputc(c, stderr);
+	}
+	return 1;
+}
+
+size_t HostLogger::write(const uint8_t* buffer, size_t size) {
+	if (!muted) {
+		fwrite(buffer, 1, size, stderr);
+	}
+	return size;
+}
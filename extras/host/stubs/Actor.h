@@ -0,0 +1,43 @@
+/*
+ * Host stand-in for the Fabrica-IO Actor base class and logger.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+#include <Storage.h>
+
+/// @brief Logger writing to stderr unless muted
+class HostLogger : public Print {
+	public:
+		size_t write(uint8_t c) override;
+		size_t write(const uint8_t* buffer, size_t size) override;
+		using Print::write;
+
+		/// @brief Suppresses output, e.g. while benchmarking
+		bool muted = false;
+};
+
+extern HostLogger Logger;
+
+/// @brief Stand-in for the Fabrica-IO actor interface
+class Actor {
+	public:
+		Actor(String Name) { Description.name = Name; }
+		virtual ~Actor() {}
+		virtual bool begin() = 0;
+		virtual String getConfig() { return "{}"; }
+		virtual bool setConfig(String config, bool save) { return false; }
+
+		/// @brief Describes this device
+		struct {
+			String name;
+			String type;
+			String version;
+			int id = 0;
+		} Description;
+
+	protected:
+		bool checkConfig(String filePath) { return Storage::fileExists(filePath); }
+		bool saveConfig(String filePath, String config) { return Storage::writeFile(filePath, config); }
+};
@@ -0,0 +1,254 @@
+#include <Arduino.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+String::String(int value, unsigned char base) : String(static_cast<long>(value), base) {}
+String::String(unsigned int value, unsigned char base) : String(static_cast<unsigned long>(value), base) {}
+
+String::String(long value, unsigned char base) {
+	if (base == 10) {
+		str = std::to_string(value);
+	} else {
+		bool negative = value < 0;
+		str = String(static_cast<unsigned long>(negative ? -value : value), base).str;
+		if (negative) {
+			str.insert(str.begin(), '-');
+		}
+	}
+}
+
+String::String(unsigned long value, unsigned char base) {
+	if (base < 2 || base > 36) {
+		base = 10;
+	}
+	do {
+		int digit = value % base;
+		str.insert(str.begin(), static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10));
+		value /= base;
+	} while (value > 0);
+}
+
+String::String(long long value) : str(std::to_string(value)) {}
+String::String(unsigned long long value) : str(std::to_string(value)) {}
+String::String(float value, unsigned int decimalPlaces) : String(static_cast<double>(value), decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces) {
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+	str = buffer;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+	size_t pos = str.find(c, from);
+	return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+	size_t pos = str.find(s.str, from);
+	return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+	if (from > to) {
+		std::swap(from, to);
+	}
+	if (from >= str.length()) {
+		return String();
+	}
+	return String(str.substr(from, to - from));
+}
+
+long String::toInt() const {
+	return strtol(str.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+	return strtof(str.c_str(), nullptr);
+}
+
+void String::trim() {
+	size_t first = str.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos) {
+		str.clear();
+		return;
+	}
+	size_t last = str.find_last_not_of(" \t\r\n");
+	str = str.substr(first, last - first + 1);
+}
+
+String operator+(const String& lhs, const String& rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const char* lhs, const String& rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, const char* rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, char rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, unsigned int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, unsigned long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, float rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, double rhs) { String s(lhs); s.concat(rhs); return s; }
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+	size_t n = 0;
+	while (size--) {
+		n += write(*buffer++);
+	}
+	return n;
+}
+
+size_t Print::print(long value, int base) {
+	return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(unsigned long value, int base) {
+	return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(long long value, int base) {
+	return base == 10 ? print(String(value)) : print(static_cast<long>(value), base);
+}
+
+size_t Print::print(unsigned long long value, int base) {
+	return base == 10 ? print(String(value)) : print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(double value, int digits) {
+	return print(String(value, static_cast<unsigned int>(digits)));
+}
+
+size_t Print::printf(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	va_list copy;
+	va_copy(copy, args);
+	int length = vsnprintf(nullptr, 0, format, copy);
+	va_end(copy);
+	if (length <= 0) {
+		va_end(args);
+		return 0;
+	}
+	std::vector<char> buffer(length + 1);
+	vsnprintf(buffer.data(), buffer.size(), format, args);
+	va_end(args);
+	return write(buffer.data(), length);
+}
+
+namespace HostClock {
+	static std::atomic<uint64_t> time_us {0};
+	static std::function<void(uint32_t)> on_advance;
+
+	/// @brief Guards the clocked thread bookkeeping
+	static std::mutex clock_lock;
+	static std::condition_variable clock_changed;
+
+	/// @brief Clocked threads currently running rather than sleeping
+	static int awake_threads = 0;
+
+	/// @brief Deadlines of sleeping clocked threads
+	static std::multiset<uint64_t> wake_times;
+
+	/// @brief True on threads started with startThread()
+	static thread_local bool clocked = false;
+
+	uint64_t now() {
+		return time_us;
+	}
+
+	void reset() {
+		time_us = 0;
+	}
+
+	/// @brief True once every clocked thread is asleep with nothing due
+	static bool quiet() {
+		return awake_threads == 0 && (wake_times.empty() || *wake_times.begin() > time_us);
+	}
+
+	void advance(uint64_t us) {
+		if (clocked) {
+			sleepUntil(time_us + us);
+			return;
+		}
+		uint64_t target = time_us + us;
+		std::unique_lock<std::mutex> guard(clock_lock);
+		while (true) {
+			clock_changed.wait(guard, quiet);
+			uint64_t current = time_us;
+			if (current >= target) {
+				return;
+			}
+			uint64_t next = std::min(target, current + maxStep);
+			if (!wake_times.empty()) {
+				next = std::min(next, *wake_times.begin());
+			}
+			guard.unlock();
+			time_us = next;
+			if (on_advance) {
+				on_advance(static_cast<uint32_t>(next - current));
+			}
+			guard.lock();
+			clock_changed.notify_all();
+		}
+	}
+
+	void setListener(std::function<void(uint32_t)> listener) {
+		on_advance = listener;
+	}
+
+	void startThread(std::function<void()> body) {
+		{
+			std::lock_guard<std::mutex> guard(clock_lock);
+			awake_threads++;
+		}
+		std::thread([body]() {
+			clocked = true;
+			body();
+			std::lock_guard<std::mutex> guard(clock_lock);
+			awake_threads--;
+			clock_changed.notify_all();
+		}).detach();
+	}
+
+	void sleepUntil(uint64_t us) {
+		if (!clocked) {
+			if (us > time_us) {
+				advance(us - time_us);
+			}
+			return;
+		}
+		std::unique_lock<std::mutex> guard(clock_lock);
+		auto slot = wake_times.insert(us);
+		awake_threads--;
+		clock_changed.notify_all();
+		clock_changed.wait(guard, [us]() { return time_us >= us; });
+		wake_times.erase(slot);
+		awake_threads++;
+	}
+}
+
+unsigned long millis() {
+	return static_cast<unsigned long>(HostClock::now() / 1000);
+}
+
+unsigned long micros() {
+	return static_cast<unsigned long>(HostClock::now());
+}
+
+void delay(unsigned long ms) {
+	HostClock::advance(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+	HostClock::advance(us);
+}
+
+void yield() {}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
@@ -0,0 +1,195 @@
+/*
+ * Host stand-in for the parts of the Arduino core used by RuckusServoWheels.
+ * Time is virtual: millis()/micros() read a clock that only moves when the
+ * simulator (or delay()) advances it. Threads started on the clock (the
+ * FreeRTOS task stand-in) run in lockstep with it.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <math.h>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper*>(pstr_pointer))
+#define HALF_PI 1.5707963267948966192313216916398
+
+/// @brief Minimal Arduino String backed by std::string
+class String {
+	public:
+		String() {}
+		String(const char* cstr) : str(cstr ? cstr : "") {}
+		String(const char* cstr, unsigned int length) : str(cstr, length) {}
+		String(const __FlashStringHelper* fstr) : str(reinterpret_cast<const char*>(fstr)) {}
+		String(const std::string& s) : str(s) {}
+		explicit String(char c) : str(1, c) {}
+		explicit String(int value, unsigned char base = 10);
+		explicit String(unsigned int value, unsigned char base = 10);
+		explicit String(long value, unsigned char base = 10);
+		explicit String(unsigned long value, unsigned char base = 10);
+		explicit String(long long value);
+		explicit String(unsigned long long value);
+		explicit String(float value, unsigned int decimalPlaces = 2);
+		explicit String(double value, unsigned int decimalPlaces = 2);
+
+		const char* c_str() const { return str.c_str(); }
+		unsigned int length() const { return str.length(); }
+		bool isEmpty() const { return str.empty(); }
+		bool reserve(unsigned int size) { str.reserve(size); return true; }
+		char charAt(unsigned int index) const { return index < str.length() ? str[index] : 0; }
+		char operator[](unsigned int index) const { return charAt(index); }
+
+		bool concat(const String& s) { str += s.str; return true; }
+		bool concat(const char* cstr) { if (cstr) str += cstr; return true; }
+		bool concat(const char* cstr, unsigned int length) { str.append(cstr, length); return true; }
+		bool concat(char c) { str += c; return true; }
+		bool concat(int value) { str += std::to_string(value); return true; }
+		bool concat(unsigned int value) { str += std::to_string(value); return true; }
+		bool concat(long value) { str += std::to_string(value); return true; }
+		bool concat(unsigned long value) { str += std::to_string(value); return true; }
+		bool concat(float value) { return concat(String(value)); }
+		bool concat(double value) { return concat(String(value)); }
+
+		template <typename T>
+		String& operator+=(const T& rhs) { concat(rhs); return *this; }
+
+		bool equals(const String& s) const { return str == s.str; }
+		bool operator==(const String& s) const { return str == s.str; }
+		bool operator==(const char* cstr) const { return str == (cstr ? cstr : ""); }
+		bool operator!=(const String& s) const { return str != s.str; }
+		bool operator!=(const char* cstr) const { return !(*this == cstr); }
+		bool operator<(const String& s) const { return str < s.str; }
+
+		bool startsWith(const String& prefix) const { return str.compare(0, prefix.str.length(), prefix.str) == 0; }
+		bool endsWith(const String& suffix) const { return str.length() >= suffix.str.length() && str.compare(str.length() - suffix.str.length(), suffix.str.length(), suffix.str) == 0; }
+		int indexOf(char c, unsigned int from = 0) const;
+		int indexOf(const String& s, unsigned int from = 0) const;
+		String substring(unsigned int from) const { return from < str.length() ? String(str.substr(from)) : String(); }
+		String substring(unsigned int from, unsigned int to) const;
+		long toInt() const;
+		float toFloat() const;
+		void trim();
+
+		/// @brief Host only: access to the underlying storage
+		const std::string& std() const { return str; }
+
+	private:
+		std::string str;
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const String& lhs, char rhs);
+String operator+(const String& lhs, int rhs);
+String operator+(const String& lhs, unsigned int rhs);
+String operator+(const String& lhs, long rhs);
+String operator+(const String& lhs, unsigned long rhs);
+String operator+(const String& lhs, float rhs);
+String operator+(const String& lhs, double rhs);
+
+/// @brief Minimal Arduino Print
+class Print {
+	public:
+		virtual ~Print() {}
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(const uint8_t* buffer, size_t size);
+		size_t write(const char* str) { return str ? write(reinterpret_cast<const uint8_t*>(str), strlen(str)) : 0; }
+		size_t write(const char* buffer, size_t size) { return write(reinterpret_cast<const uint8_t*>(buffer), size); }
+
+		size_t print(const __FlashStringHelper* fstr) { return write(reinterpret_cast<const char*>(fstr)); }
+		size_t print(const String& s) { return write(s.c_str(), s.length()); }
+		size_t print(const char* str) { return write(str); }
+		size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+		size_t print(int value, int base = 10) { return print(static_cast<long>(value), base); }
+		size_t print(unsigned int value, int base = 10) { return print(static_cast<unsigned long>(value), base); }
+		size_t print(long value, int base = 10);
+		size_t print(unsigned long value, int base = 10);
+		size_t print(long long value, int base = 10);
+		size_t print(unsigned long long value, int base = 10);
+		size_t print(double value, int digits = 2);
+		size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+		template <typename T>
+		size_t println(const T& value) { return print(value) + println(); }
+		size_t println(double value, int digits) { return print(value, digits) + println(); }
+		size_t println() { return write("\r\n"); }
+};
+
+/// @brief Minimal Arduino Stream
+class Stream : public Print {
+	public:
+		virtual int available() = 0;
+		virtual int read() = 0;
+		virtual int peek() = 0;
+};
+
+/// @brief Print that appends to a String, used to capture output on the host
+class StringPrint : public Print {
+	public:
+		StringPrint(String& Target) : target(Target) {}
+		size_t write(uint8_t c) override { target.concat(static_cast<char>(c)); return 1; }
+		size_t write(const uint8_t* buffer, size_t size) override { target.concat(reinterpret_cast<const char*>(buffer), size); return size; }
+		using Print::write;
+
+	private:
+		String& target;
+};
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+using std::min;
+using std::max;
+using std::abs;
+
+template <typename T, typename L, typename H>
+typename std::common_type<T, L, H>::type constrain(T amt, L low, H high) {
+	return amt < low ? low : (amt > high ? high : amt);
+}
+
+/// @brief Virtual clock driving millis()/micros() on the host
+namespace HostClock {
+	/// @brief Current virtual time in microseconds
+	uint64_t now();
+
+	/// @brief Resets the virtual clock to zero
+	void reset();
+
+	/// @brief Advances virtual time, notifying the listener in bounded steps so physics stays stable
+	/// @param us Microseconds to advance
+	void advance(uint64_t us);
+
+	/// @brief Registers a callback run for every step the clock advances (e.g. a physics model)
+	/// @param listener Receives the elapsed step in microseconds
+	void setListener(std::function<void(uint32_t)> listener);
+
+	/// @brief Starts a thread on the virtual clock. advance() stops at each time the thread sleeps until and waits for it to sleep again,
+	/// so the thread and the thread advancing the clock never run at once. Time passed from the thread, e.g. by delay(), sleeps it
+	/// @param body The thread's work
+	void startThread(std::function<void()> body);
+
+	/// @brief Sleeps a thread started with startThread() until virtual time reaches a deadline, advances the clock from any other thread
+	/// @param us The deadline in microseconds
+	void sleepUntil(uint64_t us);
+
+	/// @brief Largest step handed to the listener in one call
+	constexpr uint32_t maxStep = 1000;
+}
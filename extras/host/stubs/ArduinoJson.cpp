@@ -0,0 +1,669 @@
+#include <ArduinoJson.h>
+#include <cstdio>
+#include <cstdlib>
+
+using ArduinoJsonHost::Node;
+
+namespace ArduinoJsonHost {
+	Node& Node::operator=(const Node& other) {
+		if (this == &other) {
+			return *this;
+		}
+		type = other.type;
+		boolean = other.boolean;
+		integer = other.integer;
+		number = other.number;
+		single = other.single;
+		str = other.str;
+		keys = other.keys;
+		children.clear();
+		for (const auto& child : other.children) {
+			children.emplace_back(new Node(*child));
+		}
+		return *this;
+	}
+
+	void Node::clear() {
+		type = Null;
+		str.clear();
+		keys.clear();
+		children.clear();
+	}
+
+	Node* Node::find(const std::string& key) const {
+		if (type != Object) {
+			return nullptr;
+		}
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (keys[i] == key) {
+				return children[i].get();
+			}
+		}
+		return nullptr;
+	}
+
+	Node* Node::add(const std::string& key) {
+		keys.push_back(key);
+		children.emplace_back(new Node());
+		return children.back().get();
+	}
+
+	static void serializeString(const std::string& s, std::string& out) {
+		out += '"';
+		for (unsigned char c : s) {
+			switch (c) {
+				case '"': out += "\\\""; break;
+				case '\\': out += "\\\\"; break;
+				case '\b': out += "\\b"; break;
+				case '\f': out += "\\f"; break;
+				case '\n': out += "\\n"; break;
+				case '\r': out += "\\r"; break;
+				case '\t': out += "\\t"; break;
+				default:
+					if (c < 0x20) {
+						char buffer[8];
+						snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+						out += buffer;
+					} else {
+						out += static_cast<char>(c);
+					}
+			}
+		}
+		out += '"';
+	}
+
+	static void serializeNumber(double value, bool single, std::string& out) {
+		if (std::isnan(value) || std::isinf(value)) {
+			out += "null";
+			return;
+		}
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), single ? "%.7g" : "%.15g", value);
+		out += buffer;
+	}
+
+	void serialize(const Node* node, std::string& out) {
+		if (node == nullptr) {
+			out += "null";
+			return;
+		}
+		switch (node->type) {
+			case Node::Null: out += "null"; break;
+			case Node::Bool: out += node->boolean ? "true" : "false"; break;
+			case Node::Integer: out += std::to_string(node->integer); break;
+			case Node::Float: serializeNumber(node->number, node->single, out); break;
+			case Node::Str: serializeString(node->str, out); break;
+			case Node::Array:
+				out += '[';
+				for (size_t i = 0; i < node->children.size(); i++) {
+					if (i > 0) {
+						out += ',';
+					}
+					serialize(node->children[i].get(), out);
+				}
+				out += ']';
+				break;
+			case Node::Object:
+				out += '{';
+				for (size_t i = 0; i < node->children.size(); i++) {
+					if (i > 0) {
+						out += ',';
+					}
+					serializeString(node->keys[i], out);
+					out += ':';
+					serialize(node->children[i].get(), out);
+				}
+				out += '}';
+				break;
+		}
+	}
+
+	/// @brief Recursive descent JSON parser
+	class Parser {
+		public:
+			Parser(const char* Input, size_t Length) : p(Input), end(Input + Length) {}
+
+			DeserializationError parse(Node& root) {
+				skip();
+				if (p >= end) {
+					return DeserializationError::EmptyInput;
+				}
+				DeserializationError error = value(root, 0);
+				return error;
+			}
+
+		private:
+			const char* p;
+			const char* end;
+
+			void skip() {
+				while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+					p++;
+				}
+			}
+
+			DeserializationError value(Node& node, int depth) {
+				if (depth > 10) {
+					return DeserializationError::TooDeep;
+				}
+				skip();
+				if (p >= end) {
+					return DeserializationError::IncompleteInput;
+				}
+				switch (*p) {
+					case '{': return object(node, depth);
+					case '[': return array(node, depth);
+					case '"': node.type = Node::Str; return string(node.str);
+					case 't': return literal("true", node, Node::Bool, true);
+					case 'f': return literal("false", node, Node::Bool, false);
+					case 'n': return literal("null", node, Node::Null, false);
+					default: return number(node);
+				}
+			}
+
+			DeserializationError literal(const char* word, Node& node, Node::Type type, bool flag) {
+				size_t length = strlen(word);
+				if (static_cast<size_t>(end - p) < length) {
+					return DeserializationError::IncompleteInput;
+				}
+				if (strncmp(p, word, length) != 0) {
+					return DeserializationError::InvalidInput;
+				}
+				p += length;
+				node.type = type;
+				node.boolean = flag;
+				return DeserializationError::Ok;
+			}
+
+			DeserializationError number(Node& node) {
+				const char* start = p;
+				bool isFloat = false;
+				if (p < end && (*p == '-' || *p == '+')) {
+					p++;
+				}
+				while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '-' || *p == '+')) {
+					if (*p == '.' || *p == 'e' || *p == 'E') {
+						isFloat = true;
+					}
+					p++;
+				}
+				if (p == start) {
+					return DeserializationError::InvalidInput;
+				}
+				std::string text(start, p);
+				if (isFloat) {
+					node.type = Node::Float;
+					node.number = strtod(text.c_str(), nullptr);
+				} else {
+					node.type = Node::Integer;
+					node.integer = strtoll(text.c_str(), nullptr, 10);
+				}
+				return DeserializationError::Ok;
+			}
+
+			DeserializationError string(std::string& out) {
+				p++;
+				while (p < end && *p != '"') {
+					if (*p == '\\') {
+						p++;
+						if (p >= end) {
+							return DeserializationError::IncompleteInput;
+						}
+						switch (*p) {
+							case 'b': out += '\b'; break;
+							case 'f': out += '\f'; break;
+							case 'n': out += '\n'; break;
+							case 'r': out += '\r'; break;
+							case 't': out += '\t'; break;
+							case 'u': {
+								if (end - p < 5) {
+									return DeserializationError::IncompleteInput;
+								}
+								unsigned code = strtoul(std::string(p + 1, p + 5).c_str(), nullptr, 16);
+								if (code < 0x80) {
+									out += static_cast<char>(code);
+								} else if (code < 0x800) {
+									out += static_cast<char>(0xC0 | (code >> 6));
+									out += static_cast<char>(0x80 | (code & 0x3F));
+								} else {
+									out += static_cast<char>(0xE0 | (code >> 12));
+									out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+									out += static_cast<char>(0x80 | (code & 0x3F));
+								}
+								p += 4;
+								break;
+							}
+							default: out += *p;
+						}
+					} else {
+						out += *p;
+					}
+					p++;
+				}
+				if (p >= end) {
+					return DeserializationError::IncompleteInput;
+				}
+				p++;
+				return DeserializationError::Ok;
+			}
+
+			DeserializationError object(Node& node, int depth) {
+				node.type = Node::Object;
+				p++;
+				skip();
+				if (p < end && *p == '}') {
+					p++;
+					return DeserializationError::Ok;
+				}
+				while (p < end) {
+					skip();
+					if (p >= end) {
+						break;
+					}
+					if (*p != '"') {
+						return DeserializationError::InvalidInput;
+					}
+					std::string key;
+					DeserializationError error = string(key);
+					if (error) {
+						return error;
+					}
+					skip();
+					if (p >= end) {
+						break;
+					}
+					if (*p != ':') {
+						return DeserializationError::InvalidInput;
+					}
+					p++;
+					// Duplicate keys keep the last value, as ArduinoJson does
+					Node* child = node.find(key);
+					if (child == nullptr) {
+						child = node.add(key);
+					} else {
+						child->clear();
+					}
+					error = value(*child, depth + 1);
+					if (error) {
+						return error;
+					}
+					skip();
+					if (p >= end) {
+						break;
+					}
+					if (*p == ',') {
+						p++;
+					} else if (*p == '}') {
+						p++;
+						return DeserializationError::Ok;
+					} else {
+						return DeserializationError::InvalidInput;
+					}
+				}
+				return DeserializationError::IncompleteInput;
+			}
+
+			DeserializationError array(Node& node, int depth) {
+				node.type = Node::Array;
+				p++;
+				skip();
+				if (p < end && *p == ']') {
+					p++;
+					return DeserializationError::Ok;
+				}
+				while (p < end) {
+					node.children.emplace_back(new Node());
+					DeserializationError error = value(*node.children.back(), depth + 1);
+					if (error) {
+						return error;
+					}
+					skip();
+					if (p >= end) {
+						break;
+					}
+					if (*p == ',') {
+						p++;
+					} else if (*p == ']') {
+						p++;
+						return DeserializationError::Ok;
+					} else {
+						return DeserializationError::InvalidInput;
+					}
+				}
+				return DeserializationError::IncompleteInput;
+			}
+	};
+}
+
+Node* JsonVariant::resolve(bool create) const {
+	if (!parent) {
+		return node;
+	}
+	Node* container = parent->resolve(create);
+	if (container == nullptr) {
+		return nullptr;
+	}
+	if (index < 0) {
+		Node* child = container->find(key);
+		if (child != nullptr || !create) {
+			return child;
+		}
+		if (container->type == Node::Null) {
+			container->type = Node::Object;
+		}
+		if (container->type != Node::Object) {
+			return nullptr;
+		}
+		return container->add(key);
+	}
+	if (container->type == Node::Array && static_cast<size_t>(index) < container->children.size()) {
+		return container->children[index].get();
+	}
+	if (!create) {
+		return nullptr;
+	}
+	if (container->type == Node::Null) {
+		container->type = Node::Array;
+	}
+	if (container->type != Node::Array) {
+		return nullptr;
+	}
+	while (container->children.size() <= static_cast<size_t>(index)) {
+		container->children.emplace_back(new Node());
+	}
+	return container->children[index].get();
+}
+
+JsonVariant JsonVariant::operator[](const char* Key) const {
+	JsonVariant child;
+	child.parent = std::make_shared<JsonVariant>(*this);
+	child.key = Key;
+	return child;
+}
+
+JsonVariant JsonVariant::operator[](int Index) const {
+	JsonVariant child;
+	child.parent = std::make_shared<JsonVariant>(*this);
+	child.index = Index < 0 ? 0 : Index;
+	return child;
+}
+
+bool JsonVariant::isNull() const {
+	Node* n = resolve(false);
+	return n == nullptr || n->type == Node::Null;
+}
+
+size_t JsonVariant::size() const {
+	Node* n = resolve(false);
+	return n == nullptr ? 0 : n->children.size();
+}
+
+bool JsonVariant::containsKey(const char* Key) const {
+	Node* n = resolve(false);
+	return n != nullptr && n->find(Key) != nullptr;
+}
+
+JsonVariant JsonVariant::add() const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return JsonVariant();
+	}
+	if (n->type == Node::Null) {
+		n->type = Node::Array;
+	}
+	if (n->type != Node::Array) {
+		return JsonVariant();
+	}
+	n->children.emplace_back(new Node());
+	return JsonVariant(n->children.back().get());
+}
+
+bool JsonVariant::set(bool value) const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return false;
+	}
+	n->clear();
+	n->type = Node::Bool;
+	n->boolean = value;
+	return true;
+}
+
+bool JsonVariant::set(long long value) const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return false;
+	}
+	n->clear();
+	n->type = Node::Integer;
+	n->integer = value;
+	return true;
+}
+
+bool JsonVariant::set(float value) const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return false;
+	}
+	n->clear();
+	n->type = Node::Float;
+	n->number = value;
+	n->single = true;
+	return true;
+}
+
+bool JsonVariant::set(double value) const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return false;
+	}
+	n->clear();
+	n->type = Node::Float;
+	n->number = value;
+	n->single = false;
+	return true;
+}
+
+bool JsonVariant::set(const char* value) const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return false;
+	}
+	n->clear();
+	if (value != nullptr) {
+		n->type = Node::Str;
+		n->str = value;
+	}
+	return true;
+}
+
+bool JsonVariant::set(const JsonVariant& value) const {
+	Node* source = value.resolve(false);
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return false;
+	}
+	if (source == nullptr) {
+		n->clear();
+	} else if (source != n) {
+		Node copy(*source);
+		*n = copy;
+	}
+	return true;
+}
+
+template <> long long JsonVariant::as<long long>() const {
+	Node* n = resolve(false);
+	if (n == nullptr) {
+		return 0;
+	}
+	switch (n->type) {
+		case Node::Integer: return n->integer;
+		case Node::Float: return static_cast<long long>(n->number);
+		case Node::Bool: return n->boolean ? 1 : 0;
+		default: return 0;
+	}
+}
+
+template <> double JsonVariant::as<double>() const {
+	Node* n = resolve(false);
+	if (n == nullptr) {
+		return 0;
+	}
+	switch (n->type) {
+		case Node::Integer: return static_cast<double>(n->integer);
+		case Node::Float: return n->number;
+		case Node::Bool: return n->boolean ? 1 : 0;
+		default: return 0;
+	}
+}
+
+template <> int JsonVariant::as<int>() const { return static_cast<int>(as<long long>()); }
+template <> unsigned int JsonVariant::as<unsigned int>() const { return static_cast<unsigned int>(as<long long>()); }
+template <> long JsonVariant::as<long>() const { return static_cast<long>(as<long long>()); }
+template <> unsigned long JsonVariant::as<unsigned long>() const { return static_cast<unsigned long>(as<long long>()); }
+template <> unsigned long long JsonVariant::as<unsigned long long>() const { return static_cast<unsigned long long>(as<long long>()); }
+template <> float JsonVariant::as<float>() const { return static_cast<float>(as<double>()); }
+
+template <> bool JsonVariant::as<bool>() const {
+	Node* n = resolve(false);
+	if (n == nullptr) {
+		return false;
+	}
+	switch (n->type) {
+		case Node::Bool: return n->boolean;
+		case Node::Integer: return n->integer != 0;
+		case Node::Float: return n->number != 0;
+		default: return false;
+	}
+}
+
+template <> const char* JsonVariant::as<const char*>() const {
+	Node* n = resolve(false);
+	return (n != nullptr && n->type == Node::Str) ? n->str.c_str() : nullptr;
+}
+
+template <> String JsonVariant::as<String>() const {
+	Node* n = resolve(false);
+	if (n != nullptr && n->type == Node::Str) {
+		return String(n->str);
+	}
+	std::string out;
+	ArduinoJsonHost::serialize(n, out);
+	return String(out);
+}
+
+template <> JsonObject JsonVariant::as<JsonObject>() const {
+	Node* n = resolve(false);
+	return JsonObject((n != nullptr && n->type == Node::Object) ? n : nullptr);
+}
+
+template <> JsonArray JsonVariant::as<JsonArray>() const {
+	Node* n = resolve(false);
+	return JsonArray((n != nullptr && n->type == Node::Array) ? n : nullptr);
+}
+
+template <> JsonVariant JsonVariant::as<JsonVariant>() const {
+	return *this;
+}
+
+template <> JsonObject JsonVariant::to<JsonObject>() const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return JsonObject();
+	}
+	n->clear();
+	n->type = Node::Object;
+	return JsonObject(n);
+}
+
+template <> JsonArray JsonVariant::to<JsonArray>() const {
+	Node* n = resolve(true);
+	if (n == nullptr) {
+		return JsonArray();
+	}
+	n->clear();
+	n->type = Node::Array;
+	return JsonArray(n);
+}
+
+static bool isType(Node* n, Node::Type type) {
+	return n != nullptr && n->type == type;
+}
+
+template <> bool JsonVariant::is<bool>() const { return isType(resolve(false), Node::Bool); }
+template <> bool JsonVariant::is<int>() const { return isType(resolve(false), Node::Integer); }
+template <> bool JsonVariant::is<unsigned int>() const { return isType(resolve(false), Node::Integer); }
+template <> bool JsonVariant::is<long>() const { return isType(resolve(false), Node::Integer); }
+template <> bool JsonVariant::is<unsigned long>() const { return isType(resolve(false), Node::Integer); }
+template <> bool JsonVariant::is<long long>() const { return isType(resolve(false), Node::Integer); }
+template <> bool JsonVariant::is<float>() const { Node* n = resolve(false); return isType(n, Node::Float) || isType(n, Node::Integer); }
+template <> bool JsonVariant::is<double>() const { return is<float>(); }
+template <> bool JsonVariant::is<const char*>() const { return isType(resolve(false), Node::Str); }
+template <> bool JsonVariant::is<String>() const { return isType(resolve(false), Node::Str); }
+template <> bool JsonVariant::is<JsonObject>() const { return isType(resolve(false), Node::Object); }
+template <> bool JsonVariant::is<JsonArray>() const { return isType(resolve(false), Node::Array); }
+
+const char* DeserializationError::c_str() const {
+	switch (c) {
+		case Ok: return "Ok";
+		case EmptyInput: return "EmptyInput";
+		case IncompleteInput: return "IncompleteInput";
+		case InvalidInput: return "InvalidInput";
+		case NoMemory: return "NoMemory";
+		case TooDeep: return "TooDeep";
+	}
+	return "Unknown";
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length) {
+	doc.clear();
+	if (input == nullptr) {
+		return DeserializationError::EmptyInput;
+	}
+	ArduinoJsonHost::Parser parser(input, length);
+	DeserializationError error = parser.parse(*doc.node());
+	if (error) {
+		doc.clear();
+	}
+	return error;
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+	return deserializeJson(doc, input, input ? strlen(input) : 0);
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const String& input) {
+	return deserializeJson(doc, input.c_str(), input.length());
+}
+
+size_t serializeJson(const JsonVariant& source, String& output) {
+	std::string out;
+	ArduinoJsonHost::serialize(source.resolve(false), out);
+	output = String(out);
+	return out.length();
+}
+
+size_t serializeJson(const JsonVariant& source, Print& output) {
+	std::string out;
+	ArduinoJsonHost::serialize(source.resolve(false), out);
+	return output.write(out.data(), out.length());
+}
+
+size_t serializeJson(const JsonVariant& source, char* output, size_t size) {
+	std::string out;
+	ArduinoJsonHost::serialize(source.resolve(false), out);
+	if (size == 0) {
+		return 0;
+	}
+	size_t n = out.length() < size - 1 ? out.length() : size - 1;
+	memcpy(output, out.data(), n);
+	output[n] = '\0';
+	return n;
+}
+
+size_t measureJson(const JsonVariant& source) {
+	std::string out;
+	ArduinoJsonHost::serialize(source.resolve(false), out);
+	return out.length();
+}
@@ -0,0 +1,263 @@
+/*
+ * Host stand-in for the subset of ArduinoJson 7 used by RuckusServoWheels.
+ * Behaviour follows ArduinoJson where the library depends on it: missing keys
+ * read as null/zero, nested subscripts create members only on assignment, and
+ * as<String>() of a non-string serializes the value.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ArduinoJsonHost {
+	/// @brief A node in a JSON tree
+	struct Node {
+		enum Type {Null, Bool, Integer, Float, Str, Array, Object};
+		Type type = Null;
+		bool boolean = false;
+		long long integer = 0;
+		double number = 0;
+		/// @brief True if the number was assigned from a float, which serializes with float precision
+		bool single = false;
+		std::string str;
+		std::vector<std::string> keys;
+		std::vector<std::unique_ptr<Node>> children;
+
+		Node() {}
+		Node(const Node& other) { *this = other; }
+		Node& operator=(const Node& other);
+		void clear();
+		Node* find(const std::string& key) const;
+		Node* add(const std::string& key);
+	};
+
+	void serialize(const Node* node, std::string& out);
+}
+
+class JsonObject;
+class JsonArray;
+
+/// @brief Reference to a value inside a JsonDocument, possibly not created yet
+class JsonVariant {
+	public:
+		JsonVariant() {}
+		explicit JsonVariant(ArduinoJsonHost::Node* Node) : node(Node) {}
+
+		JsonVariant operator[](const char* key) const;
+		JsonVariant operator[](const String& key) const { return (*this)[key.c_str()]; }
+		JsonVariant operator[](int index) const;
+		JsonVariant operator[](size_t index) const { return (*this)[static_cast<int>(index)]; }
+
+		template <typename T> T as() const;
+		template <typename T> bool is() const;
+		bool isNull() const;
+		size_t size() const;
+		bool containsKey(const char* key) const;
+		bool containsKey(const String& key) const { return containsKey(key.c_str()); }
+		JsonVariant add() const;
+
+		template <typename T> bool add(const T& value) const { return add().set(value); }
+		template <typename T> T to() const;
+
+		bool set(bool value) const;
+		bool set(int value) const { return set(static_cast<long long>(value)); }
+		bool set(unsigned int value) const { return set(static_cast<long long>(value)); }
+		bool set(long value) const { return set(static_cast<long long>(value)); }
+		bool set(unsigned long value) const { return set(static_cast<long long>(value)); }
+		bool set(long long value) const;
+		bool set(unsigned long long value) const { return set(static_cast<long long>(value)); }
+		bool set(float value) const;
+		bool set(double value) const;
+		bool set(const char* value) const;
+		bool set(const String& value) const { return set(value.c_str()); }
+		bool set(const __FlashStringHelper* value) const { return set(reinterpret_cast<const char*>(value)); }
+		bool set(const JsonVariant& value) const;
+
+		template <typename T>
+		const JsonVariant& operator=(const T& value) const { set(value); return *this; }
+		const JsonVariant& operator=(const JsonVariant& value) const { set(value); return *this; }
+
+		/// @brief Returns the value if it is compatible with the default's type, otherwise the default
+		template <typename T> T operator|(const T& fallback) const { return is<T>() ? as<T>() : fallback; }
+		String operator|(const char* fallback) const;
+
+		/// @brief Resolves the node, creating it (and any missing parents) when requested
+		ArduinoJsonHost::Node* resolve(bool create) const;
+
+	private:
+		ArduinoJsonHost::Node* node = nullptr;
+		std::shared_ptr<JsonVariant> parent;
+		std::string key;
+		int index = -1;
+};
+
+// Conversions implemented in ArduinoJson.cpp
+template <> long long JsonVariant::as<long long>() const;
+template <> double JsonVariant::as<double>() const;
+template <> int JsonVariant::as<int>() const;
+template <> unsigned int JsonVariant::as<unsigned int>() const;
+template <> long JsonVariant::as<long>() const;
+template <> unsigned long JsonVariant::as<unsigned long>() const;
+template <> unsigned long long JsonVariant::as<unsigned long long>() const;
+template <> float JsonVariant::as<float>() const;
+template <> bool JsonVariant::as<bool>() const;
+template <> const char* JsonVariant::as<const char*>() const;
+template <> String JsonVariant::as<String>() const;
+template <> JsonObject JsonVariant::as<JsonObject>() const;
+template <> JsonArray JsonVariant::as<JsonArray>() const;
+template <> JsonVariant JsonVariant::as<JsonVariant>() const;
+template <> JsonObject JsonVariant::to<JsonObject>() const;
+template <> JsonArray JsonVariant::to<JsonArray>() const;
+template <> bool JsonVariant::is<bool>() const;
+template <> bool JsonVariant::is<int>() const;
+template <> bool JsonVariant::is<unsigned int>() const;
+template <> bool JsonVariant::is<long>() const;
+template <> bool JsonVariant::is<unsigned long>() const;
+template <> bool JsonVariant::is<long long>() const;
+template <> bool JsonVariant::is<float>() const;
+template <> bool JsonVariant::is<double>() const;
+template <> bool JsonVariant::is<const char*>() const;
+template <> bool JsonVariant::is<String>() const;
+template <> bool JsonVariant::is<JsonObject>() const;
+template <> bool JsonVariant::is<JsonArray>() const;
+
+inline String JsonVariant::operator|(const char* fallback) const {
+	return is<const char*>() ? as<String>() : String(fallback);
+}
+
+/// @brief Key of a JsonObject member
+class JsonString {
+	public:
+		JsonString(const char* Str) : str(Str) {}
+		const char* c_str() const { return str; }
+		operator const char*() const { return str; }
+		bool operator==(const char* other) const { return strcmp(str, other) == 0; }
+		bool operator!=(const char* other) const { return !(*this == other); }
+
+	private:
+		const char* str;
+};
+
+/// @brief Key/value pair produced while iterating a JsonObject
+class JsonPair {
+	public:
+		JsonPair(const std::string& Key, ArduinoJsonHost::Node* Value) : k(Key.c_str()), v(Value) {}
+		JsonString key() const { return k; }
+		JsonVariant value() const { return v; }
+
+	private:
+		JsonString k;
+		JsonVariant v;
+};
+
+/// @brief View of an object node
+class JsonObject {
+	public:
+		class iterator {
+			public:
+				iterator(ArduinoJsonHost::Node* Node, size_t Index) : node(Node), index(Index) {}
+				JsonPair operator*() const { return JsonPair(node->keys[index], node->children[index].get()); }
+				iterator& operator++() { index++; return *this; }
+				bool operator!=(const iterator& other) const { return index != other.index; }
+
+			private:
+				ArduinoJsonHost::Node* node;
+				size_t index;
+		};
+
+		JsonObject() {}
+		explicit JsonObject(ArduinoJsonHost::Node* Node) : node(Node) {}
+		iterator begin() const { return iterator(node, 0); }
+		iterator end() const { return iterator(node, node ? node->children.size() : 0); }
+		bool isNull() const { return node == nullptr; }
+		size_t size() const { return node ? node->children.size() : 0; }
+		JsonVariant operator[](const char* key) const { return JsonVariant(node)[key]; }
+		JsonVariant operator[](const String& key) const { return JsonVariant(node)[key]; }
+
+	private:
+		ArduinoJsonHost::Node* node = nullptr;
+};
+
+/// @brief View of an array node
+class JsonArray {
+	public:
+		class iterator {
+			public:
+				iterator(ArduinoJsonHost::Node* Node, size_t Index) : node(Node), index(Index) {}
+				JsonVariant operator*() const { return JsonVariant(node->children[index].get()); }
+				iterator& operator++() { index++; return *this; }
+				bool operator!=(const iterator& other) const { return index != other.index; }
+
+			private:
+				ArduinoJsonHost::Node* node;
+				size_t index;
+		};
+
+		JsonArray() {}
+		explicit JsonArray(ArduinoJsonHost::Node* Node) : node(Node) {}
+		iterator begin() const { return iterator(node, 0); }
+		iterator end() const { return iterator(node, node ? node->children.size() : 0); }
+		bool isNull() const { return node == nullptr; }
+		size_t size() const { return node ? node->children.size() : 0; }
+		JsonVariant operator[](int index) const { return JsonVariant(node)[index]; }
+		template <typename T> bool add(const T& value) const { return JsonVariant(node).add(value); }
+		template <typename T> T add() const { return JsonVariant(node).add().to<T>(); }
+
+	private:
+		ArduinoJsonHost::Node* node = nullptr;
+};
+
+/// @brief A JSON document owning its tree
+class JsonDocument {
+	public:
+		JsonDocument() : root(new ArduinoJsonHost::Node()) {}
+		JsonDocument(const JsonDocument& other) : root(new ArduinoJsonHost::Node(*other.root)) {}
+		JsonDocument& operator=(const JsonDocument& other) { *root = *other.root; return *this; }
+
+		JsonVariant operator[](const char* key) const { return JsonVariant(root.get())[key]; }
+		JsonVariant operator[](const String& key) const { return JsonVariant(root.get())[key]; }
+		JsonVariant operator[](int index) const { return JsonVariant(root.get())[index]; }
+		template <typename T> T as() const { return JsonVariant(root.get()).as<T>(); }
+		template <typename T> bool is() const { return JsonVariant(root.get()).is<T>(); }
+		template <typename T> T to() { return JsonVariant(root.get()).to<T>(); }
+		template <typename T> bool set(const T& value) { return JsonVariant(root.get()).set(value); }
+		bool isNull() const { return root->type == ArduinoJsonHost::Node::Null; }
+		size_t size() const { return root->children.size(); }
+		bool containsKey(const char* key) const { return root->find(key) != nullptr; }
+		void clear() { root->clear(); }
+		operator JsonVariant() const { return JsonVariant(root.get()); }
+		ArduinoJsonHost::Node* node() const { return root.get(); }
+
+	private:
+		std::unique_ptr<ArduinoJsonHost::Node> root;
+};
+
+/// @brief Result of deserializeJson()
+class DeserializationError {
+	public:
+		enum Code {Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep};
+		DeserializationError(Code C = Ok) : c(C) {}
+		explicit operator bool() const { return c != Ok; }
+		Code code() const { return c; }
+		const char* c_str() const;
+		const __FlashStringHelper* f_str() const { return F(c_str()); }
+
+	private:
+		Code c;
+};
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length);
+DeserializationError deserializeJson(JsonDocument& doc, const char* input);
+DeserializationError deserializeJson(JsonDocument& doc, const String& input);
+
+size_t serializeJson(const JsonVariant& source, String& output);
+size_t serializeJson(const JsonVariant& source, Print& output);
+size_t serializeJson(const JsonVariant& source, char* output, size_t size);
+size_t measureJson(const JsonVariant& source);
+inline size_t serializeJson(const JsonDocument& source, String& output) { return serializeJson(JsonVariant(source), output); }
+inline size_t serializeJson(const JsonDocument& source, Print& output) { return serializeJson(JsonVariant(source), output); }
+inline size_t serializeJson(const JsonDocument& source, char* output, size_t size) { return serializeJson(JsonVariant(source), output, size); }
+inline size_t measureJson(const JsonDocument& source) { return measureJson(JsonVariant(source)); }
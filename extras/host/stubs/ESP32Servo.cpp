@@ -0,0 +1,69 @@
+#include <ESP32Servo.h>
+#include <map>
+
+static std::map<int, const Servo*> servo_pins;
+static unsigned long write_count = 0;
+static unsigned long attach_count = 0;
+
+Servo::~Servo() {
+	detach();
+}
+
+int Servo::attach(int Pin, int Min, int Max) {
+	detach();
+	attach_count++;
+	pin = Pin;
+	min = Min < MIN_PULSE_WIDTH ? MIN_PULSE_WIDTH : Min;
+	max = Max > MAX_PULSE_WIDTH ? MAX_PULSE_WIDTH : Max;
+	servo_pins[pin] = this;
+	return pin;
+}
+
+void Servo::detach() {
+	if (pin >= 0) {
+		auto entry = servo_pins.find(pin);
+		if (entry != servo_pins.end() && entry->second == this) {
+			servo_pins.erase(entry);
+		}
+	}
+	pin = -1;
+}
+
+void Servo::write(int value) {
+	// Same conversion as ESP32Servo: small values are angles, larger ones pulse widths
+	if (value < MIN_PULSE_WIDTH) {
+		value = constrain(value, 0, 180);
+		value = map(value, 0, 180, min, max);
+	}
+	writeMicroseconds(value);
+}
+
+void Servo::writeMicroseconds(int value) {
+	write_count++;
+	if (pin < 0) {
+		return;
+	}
+	pulse = constrain(value, min, max);
+}
+
+int Servo::read() const {
+	return map(pulse + 1, min, max, 0, 180);
+}
+
+int Servo::pulseOnPin(int Pin) {
+	auto entry = servo_pins.find(Pin);
+	return entry == servo_pins.end() ? 0 : entry->second->pulse;
+}
+
+unsigned long Servo::totalWrites() {
+	return write_count;
+}
+
+unsigned long Servo::totalAttaches() {
+	return attach_count;
+}
+
+void Servo::resetCounters() {
+	write_count = 0;
+	attach_count = 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * Host stand-in for ESP32Servo. Each Servo records the pulse it was last
+ * commanded so the simulator can read wheel commands back by pin.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+
+#define MIN_PULSE_WIDTH 500
+#define MAX_PULSE_WIDTH 2500
+#define DEFAULT_PULSE_WIDTH 1500
+
+/// @brief Stand-in for the LEDC timer allocator
+class ESP32PWM {
+	public:
+		static void allocateTimer(int timerNumber) {}
+};
+
+/// @brief Stand-in for an ESP32 hobby servo
+class Servo {
+	public:
+		Servo() {}
+		~Servo();
+		void setPeriodHertz(int hertz) { period_hertz = hertz; }
+		int attach(int pin, int min = 544, int max = 2400);
+		void detach();
+		void write(int value);
+		void writeMicroseconds(int value);
+		int read() const;
+		int readMicroseconds() const { return pulse; }
+		bool attached() const { return pin >= 0; }
+
+		/// @brief Host only: the pulse last written to a pin, or 0 if nothing is attached there
+		/// @param pin The pin to look up
+		static int pulseOnPin(int pin);
+
+		/// @brief Host only: total number of writes issued to any servo
+		static unsigned long totalWrites();
+
+		/// @brief Host only: total number of attach() calls on any servo
+		static unsigned long totalAttaches();
+
+		/// @brief Host only: clears the write and attach counters
+		static void resetCounters();
+
+	private:
+		int pin = -1;
+		int min = 544;
+		int max = 2400;
+		int pulse = 0;
+		int period_hertz = 50;
+};
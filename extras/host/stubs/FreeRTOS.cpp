@@ -0,0 +1,25 @@
+#include <Arduino.h>
+#include <freertos/task.h>
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stackDepth, void* parameters, UBaseType_t priority, TaskHandle_t* created, BaseType_t core) {
+	HostClock::startThread([code, parameters]() { code(parameters); });
+	if (created != nullptr) {
+		*created = nullptr;
+	}
+	return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {}
+
+void vTaskDelay(TickType_t ticks) {
+	HostClock::advance(static_cast<uint64_t>(ticks) * portTICK_PERIOD_MS * 1000);
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+	*previousWake += increment;
+	HostClock::sleepUntil(static_cast<uint64_t>(*previousWake) * portTICK_PERIOD_MS * 1000);
+}
+
+TickType_t xTaskGetTickCount() {
+	return static_cast<TickType_t>(HostClock::now() / (portTICK_PERIOD_MS * 1000));
+}
@@ -0,0 +1,32 @@
+#include <RoboRuckusMovement.h>
+
+void RoboRuckusMovement::move(RuckusCommunicator::MoveTypes Move, int Magnitude) {
+	currentMove = Move;
+	currentMagnitude = Magnitude;
+	moving = true;
+	startMove();
+}
+
+bool RoboRuckusMovement::update() {
+	if (!moving) {
+		return true;
+	}
+	correctDrift();
+	if (shouldStop()) {
+		endMove();
+		moving = false;
+	}
+	return !moving;
+}
+
+bool RoboRuckusMovement::assignSensor(String name) {
+	for (RoboRuckusSensor* sensor : RoboRuckusSensor::ruckusSensors) {
+		if (sensor->sensorName == name) {
+			navSensor = sensor;
+			return true;
+		}
+	}
+	Logger.println("Could not find sensor " + name);
+	navSensor = nullptr;
+	return false;
+}
@@ -0,0 +1,63 @@
+/*
+ * Host stand-in for the RoboRuckus movement base class. move() and update()
+ * reproduce what the framework does with a move command: start the move, then
+ * on every pass of the main loop correct drift and check for the end.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+#include <Actor.h>
+#include <RoboRuckusSensor.h>
+#include <RuckusCommunicator.h>
+
+/// @brief Stand-in for the RoboRuckus movement base class
+class RoboRuckusMovement : public Actor {
+	public:
+		RoboRuckusMovement(String Name) : Actor(Name) {}
+
+		/// @brief Host only: starts a move as the framework would on a move command
+		/// @param Move The type of move
+		/// @param Magnitude The magnitude of the move
+		void move(RuckusCommunicator::MoveTypes Move, int Magnitude);
+
+		/// @brief Host only: one pass of the framework loop while a move is active
+		/// @return True once the move has finished
+		bool update();
+
+		/// @brief Host only: true while a move is executing
+		bool isMoving() const { return moving; }
+
+	protected:
+		/// @brief Timing and distance settings shared by all movement devices
+		struct {
+			int linearTime = 1000;
+			float linearDistance = 1;
+			float linearDrift = 1;
+			int turnTime = 500;
+			float turnDistance = 90;
+			float turnDrift = 1;
+			float driftBoost = 2;
+		} move_config;
+
+		/// @brief Sensor used to measure moves, if any
+		RoboRuckusSensor* navSensor = nullptr;
+
+		/// @brief The move currently being executed
+		RuckusCommunicator::MoveTypes currentMove = RuckusCommunicator::FORWARD;
+
+		/// @brief Magnitude of the current move
+		int currentMagnitude = 0;
+
+		/// @brief Time the current move started
+		unsigned long moveStartTime = 0;
+
+		virtual void startMove() = 0;
+		virtual void endMove() = 0;
+		virtual bool shouldStop() = 0;
+		virtual void correctDrift() = 0;
+		bool assignSensor(String name);
+
+	private:
+		bool moving = false;
+};
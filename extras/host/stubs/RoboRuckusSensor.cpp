@@ -0,0 +1,8 @@
+#include <RoboRuckusSensor.h>
+#include <algorithm>
+
+std::vector<RoboRuckusSensor*> RoboRuckusSensor::ruckusSensors;
+
+RoboRuckusSensor::~RoboRuckusSensor() {
+	ruckusSensors.erase(std::remove(ruckusSensors.begin(), ruckusSensors.end(), this), ruckusSensors.end());
+}
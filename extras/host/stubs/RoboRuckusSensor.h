@@ -0,0 +1,45 @@
+/*
+ * Host stand-in for the RoboRuckus navigation sensor interface.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+#include <RuckusCommunicator.h>
+#include <tuple>
+#include <vector>
+
+/// @brief Stand-in for a sensor that can measure RoboRuckus moves
+class RoboRuckusSensor {
+	public:
+		/// @brief Directions a sensor can report
+		enum Direction {FORWARD, BACKWARD, LEFT, RIGHT};
+
+		RoboRuckusSensor(String Name) : sensorName(Name) { ruckusSensors.push_back(this); }
+		virtual ~RoboRuckusSensor();
+
+		/// @brief Name used to assign the sensor to a movement device
+		String sensorName;
+
+		/// @brief All registered RoboRuckus sensors
+		static std::vector<RoboRuckusSensor*> ruckusSensors;
+
+		/// @brief Moves this sensor can measure the progress of
+		struct {
+			bool forward = false;
+			bool backward = false;
+			bool turnLeft = false;
+			bool turnRight = false;
+		} movementModes;
+
+		/// @brief Moves this sensor can measure drift during
+		struct {
+			bool forward = false;
+			bool backward = false;
+		} driftModes;
+
+		virtual void startMove(RuckusCommunicator::MoveTypes move) {}
+		virtual void endMove() {}
+		virtual std::tuple<Direction, float> checkDistance() { return {FORWARD, 0}; }
+		virtual std::tuple<Direction, float> checkDrift() { return {FORWARD, 0}; }
+};
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the RoboRuckus game communicator move types.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+
+/// @brief Stand-in for the RoboRuckus communicator
+class RuckusCommunicator {
+	public:
+		/// @brief Moves a bot can be asked to make
+		enum MoveTypes {TURNLEFT, TURNRIGHT, FORWARD, BACKWARD, SLIDELEFT, SLIDERIGHT};
+};
@@ -0,0 +1,47 @@
+#include <Storage.h>
+#include <map>
+
+static std::map<std::string, std::string> files;
+static unsigned long write_count = 0;
+static unsigned long bytes_written = 0;
+
+String Storage::readFile(String path) {
+	auto entry = files.find(path.std());
+	return entry == files.end() ? String() : String(entry->second);
+}
+
+bool Storage::writeFile(String path, String content) {
+	files[path.std()] = content.std();
+	write_count++;
+	bytes_written += content.length();
+	return true;
+}
+
+bool Storage::appendFile(String path, String content) {
+	files[path.std()] += content.std();
+	write_count++;
+	bytes_written += content.length();
+	return true;
+}
+
+bool Storage::fileExists(String path) {
+	return files.count(path.std()) > 0;
+}
+
+bool Storage::deleteFile(String path) {
+	return files.erase(path.std()) > 0;
+}
+
+unsigned long Storage::writeCount() {
+	return write_count;
+}
+
+unsigned long Storage::bytesWritten() {
+	return bytes_written;
+}
+
+void Storage::reset() {
+	files.clear();
+	write_count = 0;
+	bytes_written = 0;
+}
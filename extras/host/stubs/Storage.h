@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for the Fabrica-IO storage manager, backed by an in-memory
+ * file table. Counts writes so flash wear can be compared on the host.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+
+/// @brief Stand-in for the Fabrica-IO file storage helpers
+class Storage {
+	public:
+		static String readFile(String path);
+		static bool writeFile(String path, String content);
+		static bool appendFile(String path, String content);
+		static bool fileExists(String path);
+		static bool deleteFile(String path);
+
+		/// @brief Host only: number of write/append calls since the last reset
+		static unsigned long writeCount();
+
+		/// @brief Host only: number of bytes written since the last reset
+		static unsigned long bytesWritten();
+
+		/// @brief Host only: removes all files and clears counters
+		static void reset();
+};
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for the FreeRTOS types used by RuckusServoWheels.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <cstdint>
+
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdPASS 1
+#define pdFAIL 0
+
+/// @brief The host tick is 1ms, as on the Arduino ESP32 core
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms) / portTICK_PERIOD_MS)
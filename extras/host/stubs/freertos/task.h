@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for FreeRTOS tasks. Each task is a std::thread started on
+ * the virtual clock, so it runs in lockstep with the simulation: the thread
+ * advancing the clock stops at every tick a task delays until and waits for
+ * the task to delay again.
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#pragma once
+#include <freertos/FreeRTOS.h>
+
+/// @brief Starts a task, the priority and core are ignored
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stackDepth, void* parameters, UBaseType_t priority, TaskHandle_t* created, BaseType_t core);
+
+/// @brief Ends the calling task when passed nullptr, the task function must return straight after
+void vTaskDelete(TaskHandle_t task);
+
+/// @brief Delays the calling task, or advances the clock when called from outside a task
+void vTaskDelay(TickType_t ticks);
+
+/// @brief Delays the calling task until a fixed time after its last wake
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment);
+
+/// @brief Ticks since the clock started
+TickType_t xTaskGetTickCount();
@@ -0,0 +1,144 @@
+/*
+ * Host tests for RuckusServoWheels config storage. Each test starts from
+ * empty storage on a reset virtual clock, saves settings through setConfig()
+ * and boots a new instance from what was written, as a power cycle would.
+ *
+ * Usage: ruckus_config_tests
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#include <RuckusServoWheels.h>
+#include <Storage.h>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+/// @brief Number of failed checks across all tests
+static int failures = 0;
+
+/// @brief Records a failed check with its location
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			failures++; \
+		} \
+	} while (0)
+
+/// @brief Starts a two wheel instance on the storage left by the last one
+static std::unique_ptr<RuckusServoWheels> boot() {
+	std::unique_ptr<RuckusServoWheels> wheels(new RuckusServoWheels("Wheels", 12, 13));
+	CHECK(wheels->begin());
+	return wheels;
+}
+
+/// @brief Reads a number from an instance's config
+static float setting(RuckusServoWheels& wheels, const char* key) {
+	JsonDocument doc;
+	deserializeJson(doc, wheels.getConfig());
+	return doc[key].as<float>();
+}
+
+/// @brief True if two pulse widths match to within rounding
+static bool near(float a, float b) {
+	return fabsf(a - b) < 0.01;
+}
+
+/// @brief Paths the default config file is stored under
+static const char* const journalPath = "/settings/act/RuckusServoWheels.json.journal";
+static const char* const snapshotPath = "/settings/act/RuckusServoWheels.json.bin";
+
+/// @brief Moves the virtual clock forward
+static void wait(unsigned long ms) {
+	HostClock::advance(ms * 1000ULL);
+}
+
+/// @brief Clears storage and the clock before a test
+static void fresh() {
+	HostClock::reset();
+	Storage::reset();
+}
+
+/// @brief A change in servo angles and a later one in pulse widths share a journal entry, both must come back as pulse widths
+static void testJournalMixesUnits() {
+	fresh();
+	auto wheels = boot();
+	CHECK(wheels->setConfig("{\"frontRightForward\":20}", true));
+	CHECK(wheels->setConfig("{\"frontLeftForward\":2200}", true));
+	CHECK(wheels->flushConfig());
+	float right = setting(*wheels, "frontRightForward");
+	CHECK(near(right, 544 + 20 * (2400 - 544) / 180.0f));
+	wheels.reset();
+	wheels = boot();
+	CHECK(near(setting(*wheels, "frontRightForward"), right));
+	CHECK(near(setting(*wheels, "frontLeftForward"), 2200));
+}
+
+/// @brief A single saved change is on storage as soon as setConfig() returns
+static void testSingleSaveSurvivesReboot() {
+	fresh();
+	auto wheels = boot();
+	CHECK(wheels->setConfig("{\"linearTime\":1234}", true));
+	CHECK(Storage::fileExists(journalPath));
+	wheels.reset();
+	wheels = boot();
+	CHECK(setting(*wheels, "linearTime") == 1234);
+}
+
+/// @brief Changes following a write closely are held back and written together once they stop
+static void testBurstIsWrittenOnce() {
+	fresh();
+	auto wheels = boot();
+	unsigned long writes = Storage::writeCount();
+	CHECK(wheels->setConfig("{\"linearTime\":1111}", true));
+	CHECK(Storage::writeCount() == writes + 1);
+	wait(100);
+	CHECK(wheels->setConfig("{\"turnTime\":600}", true));
+	wait(100);
+	CHECK(wheels->setConfig("{\"turnTime\":650}", true));
+	CHECK(Storage::writeCount() == writes + 1);
+	wait(2000);
+	wheels->getConfig();
+	CHECK(Storage::writeCount() == writes + 2);
+	wheels.reset();
+	wheels = boot();
+	CHECK(setting(*wheels, "linearTime") == 1111);
+	CHECK(setting(*wheels, "turnTime") == 650);
+}
+
+/// @brief A full journal is folded into the JSON file and snapshot, which the next boot loads along with later entries
+static void testCompaction() {
+	fresh();
+	auto wheels = boot();
+	for (int i = 0; i < 16; i++) {
+		wait(2000);
+		CHECK(wheels->setConfig("{\"linearTime\":" + String(1000 + i) + "}", true));
+	}
+	CHECK(!Storage::fileExists(journalPath));
+	CHECK(Storage::fileExists(snapshotPath));
+	wait(2000);
+	CHECK(wheels->setConfig("{\"turnTime\":700}", true));
+	CHECK(Storage::fileExists(journalPath));
+	wheels.reset();
+	wheels = boot();
+	CHECK(setting(*wheels, "linearTime") == 1015);
+	CHECK(setting(*wheels, "turnTime") == 700);
+}
+
+int main() {
+	struct {
+		const char* name;
+		void (*run)();
+	} tests[] = {
+		{"journal mixes units", testJournalMixesUnits},
+		{"single save survives reboot", testSingleSaveSurvivesReboot},
+		{"burst is written once", testBurstIsWrittenOnce},
+		{"compaction", testCompaction},
+	};
+	for (const auto& test : tests) {
+		int before = failures;
+		test.run();
+		printf("%s: %s\n", failures == before ? "PASS" : "FAIL", test.name);
+	}
+	return failures == 0 ? 0 : 1;
+}
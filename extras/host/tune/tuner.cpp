@@ -0,0 +1,402 @@
+/*
+ * Parameter tuner for RuckusServoWheels. Searches linearTime, turnTime,
+ * linearDrift, driftBoost and the wheel speeds for the settings that finish a
+ * game turn's moves fastest with the least pose error. Every candidate runs
+ * the same move list on a set of simulated robots with random servo
+ * mismatch, wheel slip and sensor noise. Candidates are spread over worker
+ * processes, one per core. The best settings are written as a config JSON
+ * setConfig() accepts.
+ *
+ * Usage: ruckus_tune [--wheels 2|4] [--sensor nav|none] [--moves LIST]
+ *                    [--models N] [--asymmetry FRACTION] [--slip FRACTION]
+ *                    [--noise SD] [--candidates N] [--rounds N] [--workers N]
+ *                    [--time-weight MM] [--heading-weight MM] [--seed N]
+ *                    [--output FILE]
+ *
+ * Licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ */
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "SimHarness.h"
+
+/// @brief A setting the tuner searches and the range it may take
+struct TunedSetting {
+	const char* name;
+	float min;
+	float max;
+	float increment;
+	/// @brief Value in the simulator's default config
+	float initial;
+};
+
+/// @brief Settings searched. speedSpan is how far every wheel's forward and backward pulses sit from zero, leftTrim adds to that on the left wheels
+static const TunedSetting tunedSettings[] = {
+	{"linearTime", 500, 2000, 10, 1300},
+	{"turnTime", 250, 2000, 10, 450},
+	{"linearDrift", 0.2, 10, 0.1, 1},
+	{"driftBoost", 0, 200, 1, 20},
+	{"speedSpan", 150, 900, 1, 773},
+	{"leftTrim", -150, 150, 1, 0},
+};
+
+static const int settingCount = sizeof(tunedSettings) / sizeof(tunedSettings[0]);
+
+typedef std::array<float, settingCount> Candidate;
+
+/// @brief Config name prefix for each wheel
+static const char* const wheelPrefixes[] = {"frontRight", "frontLeft", "rearRight", "rearLeft"};
+
+/// @brief Score added for every move that never finished, so candidates that hang the robot lose to any that don't
+static const double timeoutPenalty = 1000;
+
+/// @brief How a candidate did over every robot model
+struct Score {
+	/// @brief Mean pose error per move, heading error converted to mm
+	double error = 0;
+	/// @brief Mean time to run the move list (ms)
+	double timeMs = 0;
+	/// @brief Moves that never finished
+	int timeouts = 0;
+	/// @brief Weighted sum of the above, lower is better
+	double total = 0;
+};
+
+/// @brief Everything fixed for a tuning run
+struct TuneOptions {
+	int wheelCount = 2;
+	bool useSensor = true;
+	std::vector<std::pair<RuckusCommunicator::MoveTypes, int>> moves;
+	int models = 16;
+	float asymmetry = 0.1;
+	float slip = 0.05;
+	float noise = 1;
+	int candidates = 256;
+	int rounds = 4;
+	int workers = 1;
+	/// @brief Pose error (mm) worth one ms of move time
+	double timeWeight = 0.02;
+	/// @brief Pose error (mm) worth one degree of heading error
+	double headingWeight = 5;
+	uint32_t seed = 1;
+	/// @brief Pulse at which each wheel is stopped and the pulse limits (us), read from the config the candidates are applied to
+	int zeroPulses[4] = {1472, 1472, 1472, 1472};
+	int servoMin = 544;
+	int servoMax = 2400;
+};
+
+/// @brief A randomized robot the candidates are run on
+struct RobotSample {
+	RobotParams robot;
+	float sensorNoise;
+};
+
+static void usage() {
+	fprintf(stderr, "Usage: ruckus_tune [--wheels 2|4] [--sensor nav|none] [--moves LIST] [--models N] [--asymmetry FRACTION]\n");
+	fprintf(stderr, "                   [--slip FRACTION] [--noise SD] [--candidates N] [--rounds N] [--workers N]\n");
+	fprintf(stderr, "                   [--time-weight MM] [--heading-weight MM] [--seed N] [--output FILE]\n");
+	fprintf(stderr, "  LIST is comma separated: F<n> forward, B<n> backward, L<n>/R<n> turns, SL<n>/SR<n> slides\n");
+	fprintf(stderr, "  --asymmetry varies every wheel's speed by up to FRACTION, --slip loses up to FRACTION of it at random\n");
+	fprintf(stderr, "  --noise gives each robot's sensor a noise SD up to SD\n");
+	fprintf(stderr, "  --candidates is the number tried in each round, later rounds search around the best so far\n");
+	fprintf(stderr, "  --time-weight is the pose error in mm worth one ms of move time, --heading-weight the mm worth one degree\n");
+}
+
+/// @brief Snaps a value onto the setting's range and increment
+static float snap(const TunedSetting& setting, float value) {
+	value = std::fmin(std::fmax(value, setting.min), setting.max);
+	return setting.min + std::round((value - setting.min) / setting.increment) * setting.increment;
+}
+
+/// @brief Reads the wheel zeros and pulse limits of the simulator's default config, which candidates are applied on top of
+static void readBaseConfig(TuneOptions& options) {
+	SimOptions sim;
+	sim.robot.wheelCount = options.wheelCount;
+	sim.useSensor = options.useSensor;
+	JsonDocument doc;
+	deserializeJson(doc, SimHarness::defaultConfig(sim));
+	for (int i = 0; i < options.wheelCount; i++) {
+		options.zeroPulses[i] = doc[String(wheelPrefixes[i]) + "Zero"] | options.zeroPulses[i];
+	}
+	options.servoMin = doc["servoMin"] | options.servoMin;
+	options.servoMax = doc["servoMax"] | options.servoMax;
+}
+
+/// @brief Config settings for a candidate, in the form SimOptions::settings takes
+static std::vector<std::pair<String, double>> candidateSettings(const Candidate& candidate, const TuneOptions& options) {
+	std::vector<std::pair<String, double>> settings;
+	for (int i = 0; i < 4; i++) {
+		// Candidates are floats, round so the JSON holds the value snapped to rather than its float approximation
+		settings.push_back({tunedSettings[i].name, std::round(candidate[i] * 1000.0) / 1000.0});
+	}
+	for (int i = 0; i < options.wheelCount; i++) {
+		float span = candidate[4] + (i % 2 == 1 ? candidate[5] : 0);
+		int zero = options.zeroPulses[i];
+		// Right wheels are mirrored, so a shorter pulse drives them forward
+		int forward = constrain((int)lround(i % 2 == 0 ? zero - span : zero + span), options.servoMin, options.servoMax);
+		int backward = constrain((int)lround(i % 2 == 0 ? zero + span : zero - span), options.servoMin, options.servoMax);
+		settings.push_back({String(wheelPrefixes[i]) + "Forward", forward});
+		settings.push_back({String(wheelPrefixes[i]) + "Backward", backward});
+	}
+	return settings;
+}
+
+/// @brief Config JSON holding a candidate's settings
+static String candidateConfig(const Candidate& candidate, const TuneOptions& options) {
+	JsonDocument doc;
+	for (const auto& setting : candidateSettings(candidate, options)) {
+		if (setting.second == (long)setting.second) {
+			doc[setting.first] = (long)setting.second;
+		} else {
+			doc[setting.first] = setting.second;
+		}
+	}
+	String output;
+	serializeJson(doc, output);
+	return output;
+}
+
+/// @brief Draws the robots candidates are scored on
+static std::vector<RobotSample> makeRobots(const TuneOptions& options, uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(0, 1);
+	std::vector<RobotSample> robots;
+	for (int i = 0; i < options.models; i++) {
+		RobotSample sample;
+		sample.robot.wheelCount = options.wheelCount;
+		for (int j = 0; j < 4; j++) {
+			sample.robot.gain[j] = 1 + options.asymmetry * (2 * unit(rng) - 1);
+		}
+		sample.robot.slip = options.slip * unit(rng);
+		sample.robot.seed = rng();
+		sample.sensorNoise = options.noise * unit(rng);
+		robots.push_back(sample);
+	}
+	return robots;
+}
+
+/// @brief Runs the move list on every robot
+/// @param config Config applied on top of the simulator default, empty to apply the settings instead
+static Score evaluate(const TuneOptions& options, const std::vector<RobotSample>& robots, const std::vector<std::pair<String, double>>& settings, const String& config = String()) {
+	Score score;
+	for (const RobotSample& sample : robots) {
+		SimOptions sim;
+		sim.robot = sample.robot;
+		sim.useSensor = options.useSensor;
+		sim.sensorNoise = sample.sensorNoise;
+		sim.settings = settings;
+		SimHarness harness(sim);
+		if (!harness.begin() || (!config.isEmpty() && !harness.wheels().setConfig(config, false))) {
+			score.timeouts += options.moves.size();
+			continue;
+		}
+		for (const auto& entry : options.moves) {
+			MoveResult result = harness.run(entry.first, entry.second);
+			score.error += result.positionError + options.headingWeight * std::fabs(result.headingError);
+			score.timeMs += result.virtualMs;
+			score.timeouts += result.timedOut ? 1 : 0;
+		}
+	}
+	score.error /= robots.size() * options.moves.size();
+	score.timeMs /= robots.size();
+	score.total = score.error + options.timeWeight * score.timeMs + timeoutPenalty * score.timeouts;
+	return score;
+}
+
+/// @brief Scores every candidate. Each worker is a forked process, the stub clock, servo pins, storage and sensor list are process wide
+static std::vector<Score> evaluateAll(const TuneOptions& options, const std::vector<RobotSample>& robots, const std::vector<Candidate>& candidates) {
+	std::vector<Score> scores(candidates.size());
+	int workers = std::min<int>(options.workers, candidates.size());
+	std::vector<std::pair<pid_t, int>> children;
+	// Output buffered before forking would be written again by every worker
+	fflush(stdout);
+	for (int w = 0; w < workers && workers > 1; w++) {
+		int fds[2];
+		if (pipe(fds) != 0) {
+			break;
+		}
+		pid_t pid = fork();
+		if (pid < 0) {
+			close(fds[0]);
+			close(fds[1]);
+			break;
+		}
+		if (pid == 0) {
+			close(fds[0]);
+			for (size_t i = w; i < candidates.size(); i += workers) {
+				Score score = evaluate(options, robots, candidateSettings(candidates[i], options));
+				if (write(fds[1], &score, sizeof(score)) != sizeof(score)) {
+					_exit(1);
+				}
+			}
+			_exit(0);
+		}
+		close(fds[1]);
+		children.push_back({pid, fds[0]});
+	}
+	int forked = children.size();
+	std::vector<bool> done(candidates.size(), false);
+	for (int w = 0; w < forked; w++) {
+		int fd = children[w].second;
+		for (size_t i = w; i < candidates.size(); i += workers) {
+			Score score;
+			size_t received = 0;
+			while (received < sizeof(score)) {
+				ssize_t count = read(fd, reinterpret_cast<char*>(&score) + received, sizeof(score) - received);
+				if (count < 0 && errno == EINTR) {
+					continue;
+				}
+				if (count <= 0) {
+					break;
+				}
+				received += count;
+			}
+			if (received < sizeof(score)) {
+				break;
+			}
+			scores[i] = score;
+			done[i] = true;
+		}
+		close(fd);
+		waitpid(children[w].first, nullptr, 0);
+	}
+	// Anything a worker couldn't be started for, or didn't finish, runs here
+	for (size_t i = 0; i < candidates.size(); i++) {
+		if (!done[i]) {
+			scores[i] = evaluate(options, robots, candidateSettings(candidates[i], options));
+		}
+	}
+	return scores;
+}
+
+static void printCandidate(const char* label, const Candidate& candidate, const Score& score) {
+	printf("%-8s %8.2f %9.2f %9.1f %8d ", label, score.total, score.error, score.timeMs, score.timeouts);
+	for (int i = 0; i < settingCount; i++) {
+		printf(" %s=%g", tunedSettings[i].name, candidate[i]);
+	}
+	printf("\n");
+}
+
+int main(int argc, char** argv) {
+	TuneOptions options;
+	unsigned int cores = std::thread::hardware_concurrency();
+	options.workers = cores > 0 ? cores : 1;
+	String moveList = "F1,B1,L1,R1,F2,L2";
+	const char* outputPath = "tuned.json";
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--wheels") && hasValue) {
+			options.wheelCount = atoi(argv[++i]) == 4 ? 4 : 2;
+		} else if (!strcmp(argv[i], "--sensor") && hasValue) {
+			options.useSensor = strcmp(argv[++i], "none") != 0;
+		} else if (!strcmp(argv[i], "--moves") && hasValue) {
+			moveList = argv[++i];
+		} else if (!strcmp(argv[i], "--models") && hasValue) {
+			options.models = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--asymmetry") && hasValue) {
+			options.asymmetry = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--slip") && hasValue) {
+			options.slip = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--noise") && hasValue) {
+			options.noise = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--candidates") && hasValue) {
+			options.candidates = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--rounds") && hasValue) {
+			options.rounds = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--workers") && hasValue) {
+			options.workers = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--time-weight") && hasValue) {
+			options.timeWeight = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--heading-weight") && hasValue) {
+			options.headingWeight = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--seed") && hasValue) {
+			options.seed = strtoul(argv[++i], nullptr, 10);
+		} else if (!strcmp(argv[i], "--output") && hasValue) {
+			outputPath = argv[++i];
+		} else {
+			usage();
+			return 2;
+		}
+	}
+	if (!SimHarness::parseMoves(moveList, options.moves) || options.moves.empty() || options.models <= 0 || options.candidates < 2 || options.rounds < 0 || options.workers <= 0) {
+		usage();
+		return 2;
+	}
+	Logger.muted = true;
+	readBaseConfig(options);
+
+	std::vector<RobotSample> robots = makeRobots(options, options.seed);
+	std::mt19937 rng(options.seed);
+	std::uniform_real_distribution<float> unit(0, 1);
+	std::normal_distribution<float> normal(0, 1);
+	printf("wheels=%d sensor=%s moves=%s models=%d workers=%d\n", options.wheelCount, options.useSensor ? "nav" : "none", moveList.c_str(), options.models, options.workers);
+	printf("%-8s %8s %9s %9s %8s  settings\n", "round", "score", "error_mm", "time_ms", "timeouts");
+
+	// The first round samples the whole range, starting from the simulator default so the result is never worse on these robots
+	std::vector<Candidate> candidates;
+	Candidate initial;
+	for (int i = 0; i < settingCount; i++) {
+		initial[i] = tunedSettings[i].initial;
+	}
+	candidates.push_back(initial);
+	while ((int)candidates.size() < options.candidates) {
+		Candidate candidate;
+		for (int i = 0; i < settingCount; i++) {
+			candidate[i] = snap(tunedSettings[i], tunedSettings[i].min + unit(rng) * (tunedSettings[i].max - tunedSettings[i].min));
+		}
+		candidates.push_back(candidate);
+	}
+	std::vector<std::pair<Score, Candidate>> ranked;
+	int elite = std::max(options.candidates / 8, 1);
+	for (int round = 0; round <= options.rounds; round++) {
+		std::vector<Score> scores = evaluateAll(options, robots, candidates);
+		for (size_t i = 0; i < candidates.size(); i++) {
+			ranked.push_back({scores[i], candidates[i]});
+		}
+		std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<Score, Candidate>& a, const std::pair<Score, Candidate>& b) { return a.first.total < b.first.total; });
+		if ((int)ranked.size() > elite) {
+			ranked.resize(elite);
+		}
+		printCandidate(String(round).c_str(), ranked.front().second, ranked.front().first);
+
+		// Later rounds search around the best candidates so far, in steps that halve each round
+		float spread = 0.15f * std::pow(0.5f, round);
+		candidates.clear();
+		for (int i = 0; (int)candidates.size() < options.candidates; i = (i + 1) % ranked.size()) {
+			Candidate candidate = ranked[i].second;
+			for (int j = 0; j < settingCount; j++) {
+				candidate[j] = snap(tunedSettings[j], candidate[j] + normal(rng) * spread * (tunedSettings[j].max - tunedSettings[j].min));
+			}
+			candidates.push_back(candidate);
+		}
+	}
+
+	// Check the winner on robots it wasn't chosen on, applying the written config the way the robot would
+	const Candidate& best = ranked.front().second;
+	String config = candidateConfig(best, options);
+	std::vector<RobotSample> holdout = makeRobots(options, options.seed + 1);
+	Score defaultScore = evaluate(options, holdout, {});
+	Score tunedScore = evaluate(options, holdout, {}, config);
+	printf("holdout:\n");
+	printCandidate("default", initial, defaultScore);
+	printCandidate("tuned", best, tunedScore);
+
+	FILE* file = fopen(outputPath, "w");
+	if (file == nullptr) {
+		fprintf(stderr, "Could not write %s\n", outputPath);
+		return 1;
+	}
+	fprintf(file, "%s\n", config.c_str());
+	fclose(file);
+	printf("%s\n", config.c_str());
+	printf("config written to %s\n", outputPath);
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include"ControlTask.h"
+
+/// @brief Starts running a function at a fixed rate
+/// @param Tick The function to run
+/// @param Context The argument passed to the function
+/// @param PeriodMs Time between runs in ms
+/// @return True on success
+bool ControlTask::start(void (*Tick)(void*), void* Context, unsigned int PeriodMs) {
+	if (active.load()) {
+		return false;
+	}
+	tick = Tick;
+	context = Context;
+	period = PeriodMs;
+	stopping.store(false);
+	active.store(true);
+	if (xTaskCreatePinnedToCore(run, "RuckusControl", taskStack, this, taskPriority, nullptr, taskCore) != pdPASS) {
+		active.store(false);
+		return false;
+	}
+	return true;
+}
+
+/// @brief Stops the task, returning once it has finished its last run
+void ControlTask::stop() {
+	if (!active.load()) {
+		return;
+	}
+	stopping.store(true);
+	while (active.load()) {
+		vTaskDelay(1);
+	}
+}
+
+/// @brief Checks if the task is running
+/// @return True if the task is running
+bool ControlTask::running() {
+	return active.load();
+}
+
+/// @brief Body of the task, runs the function every period until asked to stop
+/// @param task The ControlTask
+void ControlTask::run(void* task) {
+	ControlTask* self = static_cast<ControlTask*>(task);
+	TickType_t wake = xTaskGetTickCount();
+	while (!self->stopping.load()) {
+		self->tick(self->context);
+		vTaskDelayUntil(&wake, pdMS_TO_TICKS(self->period));
+	}
+	self->active.store(false);
+	vTaskDelete(nullptr);
+}
@@ -0,0 +1,43 @@
+/*
+ * This file and associated .cpp file are licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ * 
+ * Contributors: Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/// @brief Runs a function at a fixed rate on its own FreeRTOS task
+class ControlTask {
+	public:
+		bool start(void (*Tick)(void*), void* Context, unsigned int PeriodMs);
+		void stop();
+		bool running();
+
+	protected:
+		/// @brief Priority of the task, above the Arduino loop so the loop's work can't delay a tick
+		static const UBaseType_t taskPriority = 5;
+
+		/// @brief Core the task runs on, the same as the Arduino loop, leaving the other to WiFi
+		static const BaseType_t taskCore = 1;
+
+		/// @brief Stack size of the task in bytes
+		static const uint32_t taskStack = 4096;
+
+		/// @brief Function run every period and the argument passed to it
+		void (*tick)(void*) = nullptr;
+		void* context = nullptr;
+
+		/// @brief Time between runs in ms
+		unsigned int period = 0;
+
+		/// @brief True while the task is running
+		std::atomic<bool> active {false};
+
+		/// @brief Set to ask the task to exit
+		std::atomic<bool> stopping {false};
+
+		static void run(void* task);
+};
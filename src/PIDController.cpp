@@ -0,0 +1,47 @@
+#include"PIDController.h"
+
+/// @brief Sets the controller gains
+/// @param Kp Proportional gain
+/// @param Ki Integral gain, per second
+/// @param Kd Derivative gain, in seconds
+void PIDController::setGains(float Kp, float Ki, float Kd) {
+	kp = Kp;
+	ki = Ki;
+	kd = Kd;
+}
+
+/// @brief Sets the limit the output is clamped to
+/// @param Limit The largest output magnitude allowed
+void PIDController::setLimit(float Limit) {
+	limit = fabs(Limit);
+}
+
+/// @brief Clears the accumulated state, call at the start of each move
+void PIDController::reset() {
+	integral = 0;
+	last_error = 0;
+	started = false;
+}
+
+/// @brief Calculates the controller output for a new measurement
+/// @param error The current error (setpoint - measurement)
+/// @param now The current time in microseconds
+/// @return The clamped controller output
+float PIDController::update(float error, unsigned long now) {
+	float dt = started ? (now - last_time) / 1000000.0 : 0;
+	float derivative = dt > 0 ? (error - last_error) / dt : 0;
+	float output = kp * error + ki * integral + kd * derivative;
+	// Only integrate while the output is not saturated in the direction of the error, so the integral can't wind up
+	bool saturated = (output >= limit && error > 0) || (output <= -limit && error < 0);
+	if (!saturated && dt > 0) {
+		integral += error * dt;
+		if (ki != 0) {
+			integral = constrain(integral, -limit / fabs(ki), limit / fabs(ki));
+		}
+		output = kp * error + ki * integral + kd * derivative;
+	}
+	last_error = error;
+	last_time = now;
+	started = true;
+	return constrain(output, -limit, limit);
+}
@@ -0,0 +1,35 @@
+/*
+ * This file and associated .cpp file are licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ * 
+ * Contributors: Sam Groveman
+ */
+#pragma once
+#include <Arduino.h>
+
+/// @brief PID controller with integral anti-windup and output clamping
+class PIDController {
+	public:
+		void setGains(float Kp, float Ki, float Kd);
+		void setLimit(float Limit);
+		void reset();
+		float update(float error, unsigned long now);
+
+	protected:
+		/// @brief Proportional, integral and derivative gains (integral and derivative per second)
+		float kp = 0, ki = 0, kd = 0;
+
+		/// @brief Largest magnitude the output may take
+		float limit = 0;
+
+		/// @brief Accumulated error over time (error * seconds)
+		float integral = 0;
+
+		/// @brief Error from the previous update
+		float last_error = 0;
+
+		/// @brief Time in microseconds of the previous update
+		unsigned long last_time = 0;
+
+		/// @brief True once the controller has a previous update to work from
+		bool started = false;
+};
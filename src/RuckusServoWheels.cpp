@@ -1,5 +1,12 @@
 #include"RuckusServoWheels.h"
 
+constexpr RuckusServoWheels::moveVelocity RuckusServoWheels::moveVelocities[];
+constexpr char RuckusServoWheels::configLimits[];
+constexpr float RuckusServoWheels::rampMinimum;
+const char* const RuckusServoWheels::wheelNames[RuckusServoWheels::maxWheels] = {"frontRight", "frontLeft", "rearRight", "rearLeft"};
+const char* const RuckusServoWheels::speedNames[3] = {"Backward", "Zero", "Forward"};
+const char* const RuckusServoWheels::learnedTimeNames[RuckusServoWheels::learnedMoves] = {"forwardTime", "backwardTime", "turnLeftTime", "turnRightTime"};
+
 /// @brief Creates a RoboRuckus LED matrix controller
 /// @param Name The device name
 /// @param RightPin The pin used by the right wheel
@@ -7,8 +14,12 @@
 /// @param ConfigFile The name of the config file
 RuckusServoWheels::RuckusServoWheels(String Name, int RightPin, int LeftPin, String ConfigFile) : RoboRuckusMovement(Name) {
 	config_path = "/settings/act/" + ConfigFile;
-	wheel_config.frontLeftPin = LeftPin;
-	wheel_config.frontRightPin = RightPin;
+	snapshot_path = config_path + ".bin";
+	journal_path = config_path + ".journal";
+	RoboRuckusMovement::move_config.driftBoost = defaultDriftBoost;
+	wheel_config.wheels[0].pin = RightPin;
+	wheel_config.wheels[1].pin = LeftPin;
+	wheel_count = 2;
 }
 
 /// @brief Creates a RoboRuckus LED matrix controller
@@ -20,11 +31,19 @@ RuckusServoWheels::RuckusServoWheels(String Name, int RightPin, int LeftPin, Str
 /// @param ConfigFile The name of the config file
 RuckusServoWheels::RuckusServoWheels(String Name, int RightFrontPin, int LeftFrontPin, int RightRearPin, int LeftRearPin, String ConfigFile) : RoboRuckusMovement(Name) {
 	config_path = "/settings/act/" + ConfigFile;
-	wheel_config.frontLeftPin = LeftFrontPin;
-	wheel_config.frontRightPin = RightFrontPin;
-	wheel_config.rearLeftPin = LeftRearPin;
-	wheel_config.rearRightPin = RightRearPin;
-	four_wheels = true;
+	snapshot_path = config_path + ".bin";
+	journal_path = config_path + ".journal";
+	RoboRuckusMovement::move_config.driftBoost = defaultDriftBoost;
+	wheel_config.wheels[0].pin = RightFrontPin;
+	wheel_config.wheels[1].pin = LeftFrontPin;
+	wheel_config.wheels[2].pin = RightRearPin;
+	wheel_config.wheels[3].pin = LeftRearPin;
+	wheel_count = 4;
+}
+
+/// @brief Stops the control task, which would otherwise run on with a dangling pointer
+RuckusServoWheels::~RuckusServoWheels() {
+	control_task.stop();
 }
 
 /// @brief Starts a RoboRuckus LED matrix controller
@@ -42,81 +61,206 @@ bool RuckusServoWheels::begin() {
 	Description.version = "1.0.0";
 	if (!checkConfig(config_path)) {
 		// Set defaults
-		return setConfig(getConfig(), true);
+		return setConfig(getConfig(), false) && compactConfig();
+	}
+	// Load settings saved by the last compaction without parsing the JSON if possible
+	bool fromSnapshot = loadSnapshot();
+	if (fromSnapshot) {
+		result = applyConfig();
+		startControlTask();
 	} else {
-		// Load settings
-		return setConfig(Storage::readFile(config_path), false);
+		result = setConfig(Storage::readFile(config_path), false);
+	}
+	if (!result) {
+		return false;
+	}
+	// Apply changes saved since then
+	if (Storage::fileExists(journal_path)) {
+		String journal = Storage::readFile(journal_path);
+		int start = 0;
+		while (start < journal.length()) {
+			int end = journal.indexOf('\n', start);
+			if (end < 0) {
+				end = journal.length();
+			}
+			// An entry cut short by a power loss fails to parse and is skipped
+			if (end > start) {
+				setConfig(journal.substring(start, end), false);
+			}
+			journal_entries++;
+			start = end + 1;
+		}
 	}
+	if (!fromSnapshot) {
+		// Save a snapshot so the next boot is fast
+		return compactConfig();
+	}
+	return true;
 }
 
 /// @brief Gets the current config
 /// @return A JSON string of the config
 String RuckusServoWheels::getConfig() {
-	// Allocate the JSON document
-	JsonDocument doc;
-	doc["navSensor"]["current"] = wheel_config.navSensor;
-	doc["navSensor"]["options"][0] = "None";
+	collectControlUpdates();
+	checkPendingSave();
+	// Measure first so the string is allocated once
+	ConfigCounter counter;
+	getConfig(counter);
+	String output;
+	output.reserve(counter.length);
+	ConfigWriter writer(output);
+	getConfig(writer);
+	return output;
+}
+
+/// @brief Writes the current config as JSON straight to a stream, without building a document
+/// @param output The stream to write to
+/// @return The number of bytes written
+size_t RuckusServoWheels::getConfig(Print& output) {
+	size_t length = output.print(F("{\"navSensor\":{\"current\":"));
+	length += printJsonString(output, wheel_config.navSensor.c_str());
+	length += output.print(F(",\"options\":[\"None\""));
 	for (int i = 0; i < RoboRuckusSensor::ruckusSensors.size(); i++) {
-		doc["navSensor"]["options"][i + 1] = RoboRuckusSensor::ruckusSensors[i]->sensorName;
-	}
-	
-	// Get pins
-	doc["frontRightPin"] = wheel_config.frontRightPin;
-	doc["frontLeftPin"] = wheel_config.frontLeftPin;
-	if (four_wheels) {
-		doc["rearRightPin"] = wheel_config.rearRightPin;
-		doc["rearLeftPin"] = wheel_config.rearLeftPin;
+		length += output.print(',');
+		length += printJsonString(output, RoboRuckusSensor::ruckusSensors[i]->sensorName.c_str());
 	}
+	length += output.print(F("]}"));
 
-	// Get wheel forward speeds
-	doc["frontRightForward"] = wheel_config.frontRightForward;
-	doc["frontLeftForward"] = wheel_config.frontLeftForward;
-	if (four_wheels) {
-		doc["rearRightForward}"] = wheel_config.rearRightForward;
-		doc["rearLeftForward"] = wheel_config.rearLeftForward;
+	// Get wheel pins, speeds and zero positions
+	for (int i = 0; i < wheel_count; i++) {
+		length += printJsonKey(output, wheelNames[i], "Pin");
+		length += output.print(wheel_config.wheels[i].pin);
+		length += printJsonKey(output, wheelNames[i], "Forward");
+		length += printJsonFloat(output, wheel_config.wheels[i].speed[WHEEL_FORWARD]);
+		length += printJsonKey(output, wheelNames[i], "Backward");
+		length += printJsonFloat(output, wheel_config.wheels[i].speed[WHEEL_BACKWARD]);
+		length += printJsonKey(output, wheelNames[i], "Zero");
+		length += printJsonFloat(output, wheel_config.wheels[i].speed[WHEEL_STOP]);
+		length += printJsonKey(output, wheelNames[i], "Calibration");
+		length += output.print('[');
+		for (int j = 0; j < wheel_config.wheels[i].calibration.points; j++) {
+			length += output.print(j == 0 ? "[" : ",[");
+			length += printJsonFloat(output, wheel_config.wheels[i].calibration.pulse[j]);
+			length += output.print(',');
+			length += printJsonFloat(output, wheel_config.wheels[i].calibration.velocity[j]);
+			length += output.print(']');
+		}
+		length += output.print(']');
 	}
 
-	// Get wheel backward speeds
-	doc["frontRightBackward"] = wheel_config.frontRightBackward;
-	doc["frontLeftBackward"] = wheel_config.frontLeftBackward;
-	if (four_wheels) {
-		doc["rearRightBackward}"] = wheel_config.rearRightBackward;
-		doc["rearLeftBackward"] = wheel_config.rearLeftBackward;
-	}
+	// Get movement settings
+	length += printJsonKey(output, "linearTime");
+	length += output.print(RoboRuckusMovement::move_config.linearTime);
+	length += printJsonKey(output, "linearDistance");
+	length += printJsonFloat(output, RoboRuckusMovement::move_config.linearDistance);
+	length += printJsonKey(output, "linearDrift");
+	length += printJsonFloat(output, RoboRuckusMovement::move_config.linearDrift);
+	length += printJsonKey(output, "turnTime");
+	length += output.print(RoboRuckusMovement::move_config.turnTime);
+	length += printJsonKey(output, "turnDistance");
+	length += printJsonFloat(output, RoboRuckusMovement::move_config.turnDistance);
+	length += printJsonKey(output, "turnDrift");
+	length += printJsonFloat(output, RoboRuckusMovement::move_config.turnDrift);
+	length += printJsonKey(output, "driftBoost");
+	length += printJsonFloat(output, RoboRuckusMovement::move_config.driftBoost);
 
-	// Get wheel zero positions
-	doc["frontRightZero"] = wheel_config.frontLeftZero;
-	doc["frontLeftZero"] = wheel_config.frontLeftZero;
-	if (four_wheels) {
-		doc["rearRightZero}"] = wheel_config.rearRightZero;
-		doc["rearLeftZero"] = wheel_config.rearLeftZero;
+	length += printJsonKey(output, "servoMin");
+	length += output.print(wheel_config.servoMin);
+	length += printJsonKey(output, "servoMax");
+	length += output.print(wheel_config.servoMax);
+	length += printJsonKey(output, "settleTime");
+	length += output.print(wheel_config.settleTime);
+	length += printJsonKey(output, "slideMode");
+	length += output.print(wheel_config.slideMode);
+	length += printJsonKey(output, "wheelGeometry");
+	length += output.print(wheel_config.geometry);
+	length += printJsonKey(output, "strafeTime");
+	length += output.print(wheel_config.strafeTime);
+	length += printJsonKey(output, "swapTurns");
+	length += output.print(wheel_config.swapTurns);
+	length += printJsonKey(output, "driftMode");
+	length += output.print(wheel_config.driftMode);
+	length += printJsonKey(output, "driftKp");
+	length += printJsonFloat(output, wheel_config.driftKp);
+	length += printJsonKey(output, "driftKi");
+	length += printJsonFloat(output, wheel_config.driftKi);
+	length += printJsonKey(output, "driftKd");
+	length += printJsonFloat(output, wheel_config.driftKd);
+	length += printJsonKey(output, "rampUpTime");
+	length += output.print(wheel_config.rampUpTime);
+	length += printJsonKey(output, "rampDownTime");
+	length += output.print(wheel_config.rampDownTime);
+	length += printJsonKey(output, "sensorInterval");
+	length += output.print(wheel_config.sensorInterval);
+	length += printJsonKey(output, "controlInterval");
+	length += output.print(wheel_config.controlInterval);
+	length += printJsonKey(output, "learnTiming");
+	length += output.print(wheel_config.learnTiming);
+	for (int i = 0; i < learnedMoves; i++) {
+		length += printJsonKey(output, learnedTimeNames[i]);
+		length += printJsonFloat(output, wheel_config.learnedTimes[i]);
 	}
+	length += printJsonKey(output, "traceRecords");
+	length += output.print(wheel_config.traceRecords);
 
-	// Get movement settings
-	doc["linearTime"] = RoboRuckusMovement::move_config.linearTime;
-	doc["linearDistance"] = RoboRuckusMovement::move_config.linearDistance;
-	doc["linearDrift"] = RoboRuckusMovement::move_config.linearDrift;
-	doc["turnTime"] = RoboRuckusMovement::move_config.turnTime;
-	doc["turnDistance"] = RoboRuckusMovement::move_config.turnDistance;
-	doc["turnDrift"] = RoboRuckusMovement::move_config.turnDrift;
-	doc["driftBoost"] = RoboRuckusMovement::move_config.driftBoost;
+	length += printJsonKey(output, "limits");
+	length += output.print(FPSTR(configLimits));
+	length += output.print('}');
+	return length;
+}
 
-	doc["servoMin"] = wheel_config.servoMin;
-	doc["servoMax"] = wheel_config.servoMax;
+/// @brief Writes the separator and key of a JSON member, the key is the name followed by the suffix
+/// @param output The stream to write to
+/// @param name The start of the key
+/// @param suffix The end of the key
+/// @return The number of bytes written
+size_t RuckusServoWheels::printJsonKey(Print& output, const char* name, const char* suffix) {
+	size_t length = output.print(",\"");
+	length += output.print(name);
+	length += output.print(suffix);
+	length += output.print("\":");
+	return length;
+}
 
-	doc["limits"] = wheel_config.limits;
+/// @brief Writes a quoted and escaped JSON string
+/// @param output The stream to write to
+/// @param value The string to write
+/// @return The number of bytes written
+size_t RuckusServoWheels::printJsonString(Print& output, const char* value) {
+	size_t length = output.print('"');
+	for (const char* c = value; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			length += output.print('\\');
+			length += output.print(*c);
+		} else if ((unsigned char)*c < 0x20) {
+			length += output.printf("\\u%04x", *c);
+		} else {
+			length += output.print(*c);
+		}
+	}
+	length += output.print('"');
+	return length;
+}
 
-	// Create string to hold output
-	String output;
-	// Serialize to string
-	serializeJson(doc, output);
-	return output;
+/// @brief Writes a float as a JSON number, using as few digits as represent it
+/// @param output The stream to write to
+/// @param value The number to write
+/// @return The number of bytes written
+size_t RuckusServoWheels::printJsonFloat(Print& output, float value) {
+	if (!isfinite(value)) {
+		return output.print(F("null"));
+	}
+	char buffer[16];
+	snprintf(buffer, sizeof(buffer), "%.7g", value);
+	return output.print(buffer);
 }
 
-/// @brief Sets the configuration for this device
+/// @brief Sets the configuration for this device. A saved change is written to the journal at once unless one was written in the last saveDelay ms,
+/// changes made that closely together are written once none has been made for saveDelay ms, checked on the next setConfig(), getConfig(), startMove() or end of a move.
+/// Call flushConfig() to write them at once
 /// @param config A JSON string of the configuration settings
 /// @param save If the configuration should be saved to a file
-/// @return True on success
+/// @return True on success, false if the change was due to be written and the write failed
 bool RuckusServoWheels::setConfig(String config, bool save) {
 	// Allocate the JSON document
 	JsonDocument doc;
@@ -128,378 +272,2274 @@ bool RuckusServoWheels::setConfig(String config, bool save) {
 		Logger.println(error.f_str());
 		return false;
 	}
+	if (calibrating()) {
+		cancelCalibration();
+	}
+	// The control task reads the settings, so it is stopped while they change
+	control_task.stop();
+	collectControlUpdates();
 
-	// Assign loaded values
-	wheel_config.servoMax = doc["servoMax"].as<int>();
-	wheel_config.servoMin = doc["servoMin"].as<int>();
-	wheel_config.frontRightPin = doc["frontRightPin"].as<int>();
-	wheel_config.frontLeftPin = doc["frontLeftPin"].as<int>();
-	// Attach servos
-	front_right.setPeriodHertz(50);
-	front_right.attach(wheel_config.frontRightPin, wheel_config.servoMin, wheel_config.servoMax);
-	front_left.setPeriodHertz(50);
-	front_left.attach(wheel_config.frontLeftPin, wheel_config.servoMin, wheel_config.servoMax);
-	if (four_wheels) {
-		wheel_config.rearRightPin = doc["rearRightPin"].as<int>();
-		wheel_config.rearLeftPin = doc["rearLeftPin"].as<int>();
-		// Attach servos
-		rear_right.setPeriodHertz(50);
-		rear_right.attach(wheel_config.rearRightPin, wheel_config.servoMin, wheel_config.servoMax);
-		rear_left.setPeriodHertz(50);
-		rear_left.attach(wheel_config.rearLeftPin, wheel_config.servoMin, wheel_config.servoMax);
-	}
-
-	wheel_config.frontRightForward = doc["frontRightForward"].as<int>();
-	wheel_config.frontLeftForward = doc["frontLeftForward"].as<int>();
-	if (four_wheels) {
-		wheel_config.rearRightForward = doc["rearRightForward"].as<int>();
-		wheel_config.rearLeftForward = doc["rearLeftForward"].as<int>();
-	}
-
-	wheel_config.frontRightBackward = doc["frontRightBackward"].as<int>();
-	wheel_config.frontLeftBackward = doc["frontLeftBackward"].as<int>();
-	if (four_wheels) {
-		wheel_config.rearRightBackward = doc["rearRightBackward"].as<int>();
-		wheel_config.rearLeftBackward = doc["rearLeftBackward"].as<int>();
-	}
-
-	wheel_config.frontRightZero = doc["frontRightZero"].as<int>();
-	wheel_config.frontLeftZero = doc["frontLeftZero"].as<int>();
-	front_right.write(wheel_config.frontRightZero);
-	front_left.write(wheel_config.frontLeftZero);
-	if (four_wheels) {
-		wheel_config.rearRightZero = doc["rearRightZero"].as<int>();
-		wheel_config.rearLeftZero = doc["rearLeftZero"].as<int>();
-		rear_right.write(wheel_config.rearRightZero);
-		rear_left.write(wheel_config.rearLeftZero);
-	}
-
-	RoboRuckusMovement::move_config.linearTime = doc["linearTime"].as<int>();
-	RoboRuckusMovement::move_config.linearDistance = doc["linearDistance"].as<float>();
-	RoboRuckusMovement::move_config.linearDrift = doc["linearDrift"].as<float>();
-	RoboRuckusMovement::move_config.turnTime = doc["turnTime"].as<int>();
-	RoboRuckusMovement::move_config.turnDistance = doc["turnDistance"].as<float>();
-	RoboRuckusMovement::move_config.turnDrift = doc["turnDrift"].as<float>();
-	RoboRuckusMovement::move_config.driftBoost = doc["driftBoost"].as<float>();
-
-	wheel_config.navSensor = doc["navSensor"]["current"].as<String>();
-	if (wheel_config.navSensor != "None") {
-		if(!assignSensor(wheel_config.navSensor)) {
-			return false;
+	// Assign loaded values, only keys present are changed so partial updates and older config files both work
+	wheel_config.servoMax = doc["servoMax"] | wheel_config.servoMax;
+	wheel_config.servoMin = doc["servoMin"] | wheel_config.servoMin;
+	// Configs from before pulse widths were used hold servo angles, convert them
+	bool degrees = isDegreeConfig(doc);
+	if (degrees) {
+		Logger.println(F("Converting wheel config from degrees to microseconds"));
+	}
+	for (int i = 0; i < wheel_count; i++) {
+		String name = wheelNames[i];
+		wheel_config.wheels[i].pin = doc[name + "Pin"] | wheel_config.wheels[i].pin;
+		for (int j = 0; j < 3; j++) {
+			JsonVariant speed = doc[name + speedNames[j]];
+			if (speed.is<float>()) {
+				wheel_config.wheels[i].speed[j] = degrees ? degreesToPulse(speed.as<float>()) : speed.as<float>();
+				// Saved changes are merged into one journal entry, so it only ever holds pulse widths
+				speed.set(wheel_config.wheels[i].speed[j]);
+			}
 		}
-	} else {
-		navSensor = nullptr;
+		JsonVariant table = doc[name + "Calibration"];
+		if (table.is<JsonArray>()) {
+			loadCalibration(i, table.as<JsonArray>());
+		}
+	}
+
+	RoboRuckusMovement::move_config.linearTime = doc["linearTime"] | RoboRuckusMovement::move_config.linearTime;
+	RoboRuckusMovement::move_config.linearDistance = doc["linearDistance"] | RoboRuckusMovement::move_config.linearDistance;
+	RoboRuckusMovement::move_config.linearDrift = doc["linearDrift"] | RoboRuckusMovement::move_config.linearDrift;
+	RoboRuckusMovement::move_config.turnTime = doc["turnTime"] | RoboRuckusMovement::move_config.turnTime;
+	RoboRuckusMovement::move_config.turnDistance = doc["turnDistance"] | RoboRuckusMovement::move_config.turnDistance;
+	RoboRuckusMovement::move_config.turnDrift = doc["turnDrift"] | RoboRuckusMovement::move_config.turnDrift;
+	RoboRuckusMovement::move_config.driftBoost = doc["driftBoost"] | RoboRuckusMovement::move_config.driftBoost;
+	wheel_config.settleTime = doc["settleTime"] | wheel_config.settleTime;
+	wheel_config.slideMode = doc["slideMode"] | wheel_config.slideMode;
+	wheel_config.geometry = doc["wheelGeometry"] | wheel_config.geometry;
+	wheel_config.strafeTime = doc["strafeTime"] | wheel_config.strafeTime;
+	wheel_config.swapTurns = doc["swapTurns"] | wheel_config.swapTurns;
+	wheel_config.driftMode = doc["driftMode"] | wheel_config.driftMode;
+	wheel_config.driftKp = doc["driftKp"] | wheel_config.driftKp;
+	wheel_config.driftKi = doc["driftKi"] | wheel_config.driftKi;
+	wheel_config.driftKd = doc["driftKd"] | wheel_config.driftKd;
+	wheel_config.rampUpTime = doc["rampUpTime"] | wheel_config.rampUpTime;
+	wheel_config.rampDownTime = doc["rampDownTime"] | wheel_config.rampDownTime;
+	wheel_config.sensorInterval = doc["sensorInterval"] | wheel_config.sensorInterval;
+	wheel_config.controlInterval = doc["controlInterval"] | wheel_config.controlInterval;
+	wheel_config.learnTiming = doc["learnTiming"] | wheel_config.learnTiming;
+	for (int i = 0; i < learnedMoves; i++) {
+		wheel_config.learnedTimes[i] = doc[learnedTimeNames[i]] | wheel_config.learnedTimes[i];
+	}
+	wheel_config.traceRecords = doc["traceRecords"] | wheel_config.traceRecords;
+	if (degrees) {
+		// Corrections were in servo angle steps
+		float usPerDegree = (wheel_config.servoMax - wheel_config.servoMin) / 180.0f;
+		if (doc["driftBoost"].is<float>()) {
+			RoboRuckusMovement::move_config.driftBoost *= usPerDegree;
+			doc["driftBoost"] = RoboRuckusMovement::move_config.driftBoost;
+		}
+		if (doc["driftKp"].is<float>()) {
+			wheel_config.driftKp *= usPerDegree;
+			doc["driftKp"] = wheel_config.driftKp;
+		}
+		if (doc["driftKi"].is<float>()) {
+			wheel_config.driftKi *= usPerDegree;
+			doc["driftKi"] = wheel_config.driftKi;
+		}
+		if (doc["driftKd"].is<float>()) {
+			wheel_config.driftKd *= usPerDegree;
+			doc["driftKd"] = wheel_config.driftKd;
+		}
+	}
+	wheel_config.navSensor = doc["navSensor"]["current"] | wheel_config.navSensor;
+	bool applied = applyConfig();
+	startControlTask();
+	if (!applied) {
+		return false;
 	}
 	
 	if (save) {
-		return saveConfig(config_path, config);
+		// Merge into the changes waiting to be saved, limits are only ever sent out
+		for (JsonPair setting : doc.as<JsonObject>()) {
+			if (setting.key() != "limits") {
+				pending_config[setting.key().c_str()] = setting.value();
+			}
+		}
+		return queueSave();
 	}
 	return true;
 }
 
-/// @brief Starts a move
-void RuckusServoWheels::startMove() {
-	if (navSensor != nullptr) {
-		navSensor->startMove(currentMove);
-	}
-	moveStartTime = millis();
-	switch (currentMove) {
-		case RuckusCommunicator::MoveTypes::FORWARD:
-			front_right.write(wheel_config.frontRightForward);
-			front_left.write(wheel_config.frontLeftForward);
-			if (four_wheels) {
-				rear_right.write(wheel_config.rearRightForward);
-				rear_left.write(wheel_config.rearLeftForward);
-			}
-			break;
-		case RuckusCommunicator::MoveTypes::BACKWARD:
-			front_right.write(wheel_config.frontRightBackward);
-			front_left.write(wheel_config.frontLeftBackward);
-			if (four_wheels) {
-				rear_right.write(wheel_config.rearRightBackward);
-				rear_left.write(wheel_config.rearLeftBackward);
-			}
-			break;
-		case RuckusCommunicator::MoveTypes::TURNLEFT:
-			front_right.write(wheel_config.frontRightBackward);
-			front_left.write(wheel_config.frontLeftForward);
-			if (four_wheels) {
-				rear_right.write(wheel_config.rearRightBackward);
-				rear_left.write(wheel_config.rearLeftForward);
-			}
-			break;
-		case RuckusCommunicator::MoveTypes::TURNRIGHT:
-			front_right.write(wheel_config.frontRightForward);
-			front_left.write(wheel_config.frontLeftBackward);
-			if (four_wheels) {
-				rear_right.write(wheel_config.rearRightForward);
-				rear_left.write(wheel_config.rearLeftBackward);
+/// @brief Checks if a config holds wheel speeds as servo angles (0-180) rather than pulse widths
+/// @param doc The config
+/// @return True if any wheel speed in the config is an angle
+bool RuckusServoWheels::isDegreeConfig(JsonDocument& doc) {
+	for (int i = 0; i < wheel_count; i++) {
+		String name = wheelNames[i];
+		for (int j = 0; j < 3; j++) {
+			JsonVariant speed = doc[name + speedNames[j]];
+			if (speed.is<float>() && speed.as<float>() <= 180) {
+				return true;
 			}
+		}
+	}
+	return false;
+}
+
+/// @brief Loads a wheel's calibration table from a config array of [pulse, velocity] pairs, sorting it by pulse width
+/// @param wheel The index of the wheel
+/// @param table The table from the config, an empty array clears the calibration
+void RuckusServoWheels::loadCalibration(int wheel, JsonArray table) {
+	wheelCalibration& calibration = wheel_config.wheels[wheel].calibration;
+	calibration.points = 0;
+	for (JsonVariant point : table) {
+		if (calibration.points >= calibrationPoints) {
 			break;
-		case RuckusCommunicator::SLIDELEFT:
-		case RuckusCommunicator::SLIDERIGHT:
-			compoundMove = true;
-			currentMoveState = START;
-			break;
+		}
+		float pulse = point[0].as<float>();
+		float velocity = point[1].as<float>();
+		// Insertion sort, the table is tiny
+		int j = calibration.points;
+		while (j > 0 && calibration.pulse[j - 1] > pulse) {
+			calibration.pulse[j] = calibration.pulse[j - 1];
+			calibration.velocity[j] = calibration.velocity[j - 1];
+			j--;
+		}
+		calibration.pulse[j] = pulse;
+		calibration.velocity[j] = velocity;
+		calibration.points++;
 	}
 }
 
-/// @brief End movement
-void RuckusServoWheels::endMove() {
-	resetMove();
-	compoundMove = false;
+/// @brief Looks up the velocity a wheel reaches at a pulse width, interpolating between calibration points
+/// @param wheel The index of the wheel
+/// @param pulse The pulse width in us
+/// @return The velocity, held at the end points outside the table
+float RuckusServoWheels::velocityForPulse(int wheel, float pulse) {
+	const wheelCalibration& calibration = wheel_config.wheels[wheel].calibration;
+	int last = calibration.points - 1;
+	if (pulse <= calibration.pulse[0]) {
+		return calibration.velocity[0];
+	}
+	if (pulse >= calibration.pulse[last]) {
+		return calibration.velocity[last];
+	}
+	int j = 1;
+	while (calibration.pulse[j] < pulse) {
+		j++;
+	}
+	float fraction = (pulse - calibration.pulse[j - 1]) / (calibration.pulse[j] - calibration.pulse[j - 1]);
+	return calibration.velocity[j - 1] + fraction * (calibration.velocity[j] - calibration.velocity[j - 1]);
 }
 
-/// @brief Checks if a movement should stop
-/// @return True if the movement should stop
-bool RuckusServoWheels::shouldStop() {
-	bool done = false;
-	if (!compoundMove) {
-		done = checkForEnd();
+/// @brief Looks up the pulse width that drives a wheel at a velocity, interpolating between calibration points
+/// @param wheel The index of the wheel
+/// @param velocity The velocity
+/// @return The pulse width in us, the closest end point if the velocity is out of range
+float RuckusServoWheels::pulseForVelocity(int wheel, float velocity) {
+	const wheelCalibration& calibration = wheel_config.wheels[wheel].calibration;
+	// Velocity falls with pulse width on wheels mounted on the right, flip it so the search always runs uphill
+	float direction = calibration.velocity[calibration.points - 1] >= calibration.velocity[0] ? 1 : -1;
+	float target = velocity * direction;
+	if (target <= calibration.velocity[0] * direction) {
+		return calibration.pulse[0];
+	}
+	for (int j = 1; j < calibration.points; j++) {
+		float upper = calibration.velocity[j] * direction;
+		if (target <= upper) {
+			float lower = calibration.velocity[j - 1] * direction;
+			float fraction = upper > lower ? (target - lower) / (upper - lower) : 0;
+			return calibration.pulse[j - 1] + fraction * (calibration.pulse[j] - calibration.pulse[j - 1]);
+		}
+	}
+	return calibration.pulse[calibration.points - 1];
+}
+
+/// @brief Works out the pulse width that speeds a wheel up, or slows it down, from its speed for the current move
+/// @param wheel The index of the wheel
+/// @param change The change in us of pulse width, positive speeds the wheel up. Calibrated wheels change velocity by the amount this would at the wheel's average response
+/// @return The pulse width in us
+float RuckusServoWheels::adjustSpeed(int wheel, float change) {
+	float zero = wheel_config.wheels[wheel].speed[WHEEL_STOP];
+	float offset = move_speeds[wheel] - zero;
+	float pulse;
+	if (calibrated && fabsf(offset) >= 1) {
+		float velocity = move_velocities[wheel];
+		float slope = fabsf(velocity / offset);
+		pulse = pulseForVelocity(wheel, velocity + (velocity < 0 ? -change : change) * slope);
 	} else {
-		switch (currentMoveState) {
-			case START:
-				compoundMoveType = currentMove;
-				compoundMoveMagnitude = currentMagnitude;
-				currentMagnitude = 1;
-				if (compoundMoveType == RuckusCommunicator::SLIDELEFT) {
-					currentMove = RuckusCommunicator::TURNLEFT;
-					currentMoveState = LEFT;
-				} else {
-					currentMove = RuckusCommunicator::TURNRIGHT;
-					currentMoveState = RIGHT;
-				}
-				startMove();
-				break;
-			case LEFT:
-				if (checkForEnd()) {
-					if (compoundMoveType == RuckusCommunicator::SLIDELEFT) {
-						resetMove();
-						delay(250);
-						currentMove = RuckusCommunicator::FORWARD;
-						currentMoveState = FORWARD;
-						currentMagnitude = compoundMoveMagnitude;
-						startMove();
-					} else {
-						done = true;
-					}
-				}
-				break;
-			case RIGHT:
-				if (checkForEnd()) {
-					if (compoundMoveType == RuckusCommunicator::SLIDELEFT) {
-						done = true;
-					} else {
-						resetMove();
-						delay(250);
-						currentMove = RuckusCommunicator::FORWARD;
-						currentMoveState = FORWARD;
-						currentMagnitude = compoundMoveMagnitude;
-						startMove();
-					}
-				}
-				break;
-			case FORWARD:
-				if (checkForEnd()) {
-					resetMove();
-					delay(250);
-					currentMagnitude = 1;
-					if (compoundMoveType == RuckusCommunicator::SLIDELEFT) {
-						currentMove = RuckusCommunicator::TURNRIGHT;
-						currentMoveState = RIGHT;
-					} else {
-						currentMove = RuckusCommunicator::TURNLEFT;
-						currentMoveState = LEFT;
-						startMove();
-					}
-					startMove();
-				}
-				break;
+		pulse = offset < 0 ? move_speeds[wheel] - change : move_speeds[wheel] + change;
+	}
+	return constrain(pulse, (float)wheel_config.servoMin, (float)wheel_config.servoMax);
+}
+
+/// @brief Converts a servo angle to the pulse width Servo::write() would use for it
+/// @param degrees The angle
+/// @return The pulse width in us
+float RuckusServoWheels::degreesToPulse(float degrees) {
+	return wheel_config.servoMin + degrees * (wheel_config.servoMax - wheel_config.servoMin) / 180.0f;
+}
+
+/// @brief Saves any pending config changes to the journal now
+/// @return True on success
+bool RuckusServoWheels::flushConfig() {
+	if (!save_pending) {
+		return true;
+	}
+	String entry;
+	serializeJson(pending_config, entry);
+	entry += '\n';
+	// Keep the changes pending if the write fails so they are tried again
+	if (!Storage::appendFile(journal_path, entry)) {
+		return false;
+	}
+	pending_config.clear();
+	save_pending = false;
+	journal_written = true;
+	last_save_time = millis();
+	journal_entries++;
+	if (journal_entries >= journalLimit) {
+		return compactConfig();
+	}
+	return true;
+}
+
+/// @brief Marks pending_config as changed, writing it at once unless the journal was written in the last saveDelay ms
+/// @return False if the write was due and failed, the changes stay pending and are tried again saveDelay ms later
+bool RuckusServoWheels::queueSave() {
+	save_pending = true;
+	last_change_time = millis();
+	// Only a burst of changes is held back, so a single change survives a power cycle straight away
+	if (journal_written && millis() - last_save_time < saveDelay) {
+		return true;
+	}
+	if (!flushConfig()) {
+		Logger.println(F("Could not save config changes, retrying"));
+		return false;
+	}
+	return true;
+}
+
+/// @brief Saves pending config changes once no change has been made for saveDelay ms, so a run of changes is written once. A failed write is tried again saveDelay ms later
+void RuckusServoWheels::checkPendingSave() {
+	if (save_pending && millis() - last_change_time >= saveDelay && !flushConfig()) {
+		Logger.println(F("Could not save config changes, retrying"));
+		last_change_time = millis();
+	}
+}
+
+/// @brief Rewrites the full JSON config and the snapshot from the current settings and clears the journal
+/// @return True on success
+bool RuckusServoWheels::compactConfig() {
+	pending_config.clear();
+	save_pending = false;
+	if (!saveConfig(config_path, getConfig()) || !saveSnapshot()) {
+		return false;
+	}
+	journal_entries = 0;
+	if (Storage::fileExists(journal_path)) {
+		return Storage::deleteFile(journal_path);
+	}
+	return true;
+}
+
+/// @brief Puts the loaded settings into effect: attaches and stops the servos, sets the drift controller gains and assigns the nav sensor
+/// @return True on success
+bool RuckusServoWheels::applyConfig() {
+	for (int i = 0; i < wheel_count; i++) {
+		// Attach servo only if its output has changed, and stop wheel
+		if (attached_pins[i] != wheel_config.wheels[i].pin || attached_min != wheel_config.servoMin || attached_max != wheel_config.servoMax) {
+			servos[i].setPeriodHertz(50);
+			servos[i].attach(wheel_config.wheels[i].pin, wheel_config.servoMin, wheel_config.servoMax);
+			attached_pins[i] = wheel_config.wheels[i].pin;
+			servo_values[i] = -1;
 		}
+		writeServo(i, wheel_config.wheels[i].speed[WHEEL_STOP]);
 	}
-	return done;
+	attached_min = wheel_config.servoMin;
+	attached_max = wheel_config.servoMax;
+	drift_pid.setGains(wheel_config.driftKp, wheel_config.driftKi, wheel_config.driftKd);
+	for (int i = 0; i < learnedMoves; i++) {
+		learned_times[i] = wheel_config.learnedTimes[i];
+	}
+	resizeTrace();
+	calibrated = true;
+	for (int i = 0; i < wheel_count; i++) {
+		calibrated = calibrated && wheel_config.wheels[i].calibration.points >= 2;
+	}
+
+	if (wheel_config.navSensor != "None") {
+		if(!assignSensor(wheel_config.navSensor)) {
+			return false;
+		}
+	} else {
+		navSensor = nullptr;
+	}
+	return true;
 }
 
-/// @brief Adjusts the wheel speeds based on drift measurements, if supported
-void RuckusServoWheels::correctDrift() {
-	if (navSensor != nullptr) {
-		int frontWheelRight;
-		int frontWheelLeft;
-		int rearWheelRight;
-		int rearWheelLeft;
-		bool shouldCorrect = false;
-		switch (currentMove) {
-			case RuckusCommunicator::MoveTypes::FORWARD:
-				shouldCorrect = navSensor->driftModes.forward;
-				frontWheelRight = wheel_config.frontRightForward;
-				frontWheelLeft = wheel_config.frontLeftForward;
-				if (four_wheels) {
-					rearWheelRight = wheel_config.rearRightForward;
-					rearWheelLeft = wheel_config.rearLeftForward;
-				}
-				break;
-			case RuckusCommunicator::MoveTypes::BACKWARD:
-				shouldCorrect = navSensor->driftModes.backward;
-				frontWheelRight = wheel_config.frontRightBackward;
-				frontWheelLeft = wheel_config.frontLeftBackward;
-				if (four_wheels) {
-					rearWheelRight = wheel_config.rearRightBackward;
-					rearWheelLeft = wheel_config.rearLeftBackward;
-				}
-				break;
+/// @brief Saves the settings as a fixed layout snapshot next to the JSON config, hex encoded as storage works with text
+/// @return True on success
+bool RuckusServoWheels::saveSnapshot() {
+	configSnapshot snapshot = {};
+	snapshot.magic = snapshotMagic;
+	snapshot.version = snapshotVersion;
+	snapshot.size = sizeof(configSnapshot);
+	snapshot.wheelCount = wheel_count;
+	strncpy(snapshot.navSensor, wheel_config.navSensor.c_str(), sizeof(snapshot.navSensor) - 1);
+	for (int i = 0; i < maxWheels; i++) {
+		snapshot.wheels[i].pin = wheel_config.wheels[i].pin;
+		for (int j = 0; j < 3; j++) {
+			snapshot.wheels[i].speed[j] = wheel_config.wheels[i].speed[j];
 		}
-		if (shouldCorrect) {			
-			std::tuple<RoboRuckusSensor::Direction, float> result =	navSensor->checkDrift();
-			if (std::get<1>(result) >= RoboRuckusMovement::move_config.linearDrift) {
-				if (std::get<0>(result) == RoboRuckusSensor::LEFT) {
-					switch (currentMove) {
-						case RuckusCommunicator::MoveTypes::FORWARD:
-							if (frontWheelLeft < wheel_config.frontLeftZero) {
-								frontWheelLeft -= RoboRuckusMovement::move_config.driftBoost;
-							} else {
-								frontWheelLeft += RoboRuckusMovement::move_config.driftBoost;
-							}
-							if (four_wheels) {
-								if (rearWheelLeft < wheel_config.rearLeftZero) {
-									rearWheelLeft -= RoboRuckusMovement::move_config.driftBoost;
-								} else {
-									rearWheelLeft += RoboRuckusMovement::move_config.driftBoost;
-								}
-							}
-							break;
-						case RuckusCommunicator::MoveTypes::BACKWARD:
-							if (frontWheelRight < wheel_config.frontRightZero) {
-								frontWheelRight -= RoboRuckusMovement::move_config.driftBoost;
-							} else {
-								frontWheelRight += RoboRuckusMovement::move_config.driftBoost;
-							}
-							if (four_wheels) {
-								if (rearWheelRight < wheel_config.rearRightZero) {
-									rearWheelRight -= RoboRuckusMovement::move_config.driftBoost;
-								} else {
-									rearWheelRight += RoboRuckusMovement::move_config.driftBoost;
-								}
-							}
-							break;
-					}	
-				} else if (std::get<0>(result) == RoboRuckusSensor::RIGHT) {
-					switch (currentMove) {
-						case RuckusCommunicator::MoveTypes::FORWARD:
-							if (frontWheelRight < wheel_config.frontRightZero) {
-								frontWheelRight -= RoboRuckusMovement::move_config.driftBoost;
-							} else {
-								frontWheelRight += RoboRuckusMovement::move_config.driftBoost;
-							}
-							if (four_wheels) {
-								if (rearWheelRight < wheel_config.rearRightZero) {
-									rearWheelRight -= RoboRuckusMovement::move_config.driftBoost;
-								} else {
-									rearWheelRight += RoboRuckusMovement::move_config.driftBoost;
-								}
-							}
-							break;
-						case RuckusCommunicator::MoveTypes::BACKWARD:
-							if (frontWheelLeft < wheel_config.frontLeftZero) {
-								frontWheelLeft -= RoboRuckusMovement::move_config.driftBoost;
-							} else {
-								frontWheelLeft += RoboRuckusMovement::move_config.driftBoost;
-							}
-							if (four_wheels) {
-								if (rearWheelLeft < wheel_config.rearLeftZero) {
-									rearWheelLeft -= RoboRuckusMovement::move_config.driftBoost;
-								} else {
-									rearWheelLeft += RoboRuckusMovement::move_config.driftBoost;
-								}
-							}
-							break;
-					}	
-				}
-			}
-			front_right.write(frontWheelRight);
-			front_left.write(frontWheelLeft);
-			if (four_wheels) {
-				rear_right.write(rearWheelRight);
-				rear_left.write(rearWheelLeft);
-			}
+		snapshot.wheels[i].calibrationCount = wheel_config.wheels[i].calibration.points;
+		for (int j = 0; j < calibrationPoints; j++) {
+			snapshot.wheels[i].calibrationPulse[j] = wheel_config.wheels[i].calibration.pulse[j];
+			snapshot.wheels[i].calibrationVelocity[j] = wheel_config.wheels[i].calibration.velocity[j];
 		}
 	}
+	snapshot.servoMin = wheel_config.servoMin;
+	snapshot.servoMax = wheel_config.servoMax;
+	snapshot.settleTime = wheel_config.settleTime;
+	snapshot.slideMode = wheel_config.slideMode;
+	snapshot.geometry = wheel_config.geometry;
+	snapshot.strafeTime = wheel_config.strafeTime;
+	snapshot.swapTurns = wheel_config.swapTurns;
+	snapshot.driftMode = wheel_config.driftMode;
+	snapshot.driftKp = wheel_config.driftKp;
+	snapshot.driftKi = wheel_config.driftKi;
+	snapshot.driftKd = wheel_config.driftKd;
+	snapshot.rampUpTime = wheel_config.rampUpTime;
+	snapshot.rampDownTime = wheel_config.rampDownTime;
+	snapshot.sensorInterval = wheel_config.sensorInterval;
+	snapshot.controlInterval = wheel_config.controlInterval;
+	snapshot.learnTiming = wheel_config.learnTiming;
+	for (int i = 0; i < learnedMoves; i++) {
+		snapshot.learnedTimes[i] = wheel_config.learnedTimes[i];
+	}
+	snapshot.traceRecords = wheel_config.traceRecords;
+	snapshot.linearTime = RoboRuckusMovement::move_config.linearTime;
+	snapshot.linearDistance = RoboRuckusMovement::move_config.linearDistance;
+	snapshot.linearDrift = RoboRuckusMovement::move_config.linearDrift;
+	snapshot.turnTime = RoboRuckusMovement::move_config.turnTime;
+	snapshot.turnDistance = RoboRuckusMovement::move_config.turnDistance;
+	snapshot.turnDrift = RoboRuckusMovement::move_config.turnDrift;
+	snapshot.driftBoost = RoboRuckusMovement::move_config.driftBoost;
+	snapshot.crc = crc32(reinterpret_cast<const uint8_t*>(&snapshot), offsetof(configSnapshot, crc));
+
+	static const char hex[] = "0123456789abcdef";
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&snapshot);
+	String encoded;
+	encoded.reserve(sizeof(configSnapshot) * 2);
+	for (size_t i = 0; i < sizeof(configSnapshot); i++) {
+		encoded += hex[bytes[i] >> 4];
+		encoded += hex[bytes[i] & 0x0f];
+	}
+	return Storage::writeFile(snapshot_path, encoded);
 }
 
-/// @brief Custom function to check if a non-slide move should end
-/// @return True if the move should stop
-bool RuckusServoWheels::checkForEnd() {
-	long timeMoving = millis() - moveStartTime;
-	bool done = false;
-	switch (currentMove) {
-		case RuckusCommunicator::MoveTypes::FORWARD:
-			if (timeMoving >= (currentMagnitude * RoboRuckusMovement::move_config.linearTime)) {
-				done = true;
-			} else {
-				if (navSensor != nullptr) {
-					if (navSensor->movementModes.forward) {
-						std::tuple<RoboRuckusSensor::Direction, float> result =	navSensor->checkDistance();
-						if (std::get<0>(result) == RoboRuckusSensor::FORWARD) {
-							done = std::get<1>(result) >= (RoboRuckusMovement::move_config.linearDistance * currentMagnitude);
-						}
-					}
-				}
-			}
-			break;
-		case RuckusCommunicator::MoveTypes::BACKWARD:
-			if (timeMoving > (currentMagnitude * RoboRuckusMovement::move_config.linearTime)) {
-				done = true;
-			} else {
-				if (navSensor != nullptr) {
-					if (navSensor->movementModes.backward) {
-						std::tuple<RoboRuckusSensor::Direction, float> result =	navSensor->checkDistance();
-						if (std::get<0>(result) == RoboRuckusSensor::BACKWARD) {
-							done = std::get<1>(result) >= (RoboRuckusMovement::move_config.linearDistance * currentMagnitude);
-						}
-					}
-				}
-			}
-			break;
-		case RuckusCommunicator::MoveTypes::TURNRIGHT:
-			if (timeMoving > (currentMagnitude * RoboRuckusMovement::move_config.turnTime)) {
-				done = true;
-			} else {
-				if (navSensor != nullptr) {
-					if (navSensor->movementModes.turnRight) {
-						std::tuple<RoboRuckusSensor::Direction, float> result =	navSensor->checkDistance();
-						if (std::get<0>(result) == RoboRuckusSensor::RIGHT) {
-							done = std::get<1>(result) >= (RoboRuckusMovement::move_config.turnDistance * currentMagnitude);
-						}
-					}
-				}
-			}
-			break;
-		case RuckusCommunicator::MoveTypes::TURNLEFT:
-			if (timeMoving > (currentMagnitude * RoboRuckusMovement::move_config.turnTime)) {
-				done = true;
-			} else {
-				if (navSensor != nullptr) {
-					if (navSensor->movementModes.turnLeft) {
-						std::tuple<RoboRuckusSensor::Direction, float> result =	navSensor->checkDistance();
-						if (std::get<0>(result) == RoboRuckusSensor::LEFT) {
-							done = std::get<1>(result) >= (RoboRuckusMovement::move_config.turnDistance * currentMagnitude);
-						}
-					}
-				}
-			}
-			break;
+/// @brief Loads the settings from the snapshot saved by saveSnapshot()
+/// @return True if the snapshot exists, matches this version and wheel count, and passes its CRC
+bool RuckusServoWheels::loadSnapshot() {
+	if (!Storage::fileExists(snapshot_path)) {
+		return false;
 	}
-	return done;
+	String encoded = Storage::readFile(snapshot_path);
+	if (encoded.length() != sizeof(configSnapshot) * 2) {
+		return false;
+	}
+	configSnapshot snapshot;
+	uint8_t* bytes = reinterpret_cast<uint8_t*>(&snapshot);
+	for (size_t i = 0; i < sizeof(configSnapshot); i++) {
+		int high = hexValue(encoded[i * 2]);
+		int low = hexValue(encoded[i * 2 + 1]);
+		if (high < 0 || low < 0) {
+			return false;
+		}
+		bytes[i] = high << 4 | low;
+	}
+	if (snapshot.magic != snapshotMagic || snapshot.version != snapshotVersion || snapshot.size != sizeof(configSnapshot) || snapshot.wheelCount != wheel_count) {
+		return false;
+	}
+	if (snapshot.crc != crc32(bytes, offsetof(configSnapshot, crc))) {
+		Logger.println(F("Config snapshot failed CRC, loading JSON config"));
+		return false;
+	}
+
+	snapshot.navSensor[sizeof(snapshot.navSensor) - 1] = '\0';
+	wheel_config.navSensor = snapshot.navSensor;
+	for (int i = 0; i < maxWheels; i++) {
+		wheel_config.wheels[i].pin = snapshot.wheels[i].pin;
+		for (int j = 0; j < 3; j++) {
+			wheel_config.wheels[i].speed[j] = snapshot.wheels[i].speed[j];
+		}
+		wheel_config.wheels[i].calibration.points = constrain(snapshot.wheels[i].calibrationCount, 0, calibrationPoints);
+		for (int j = 0; j < calibrationPoints; j++) {
+			wheel_config.wheels[i].calibration.pulse[j] = snapshot.wheels[i].calibrationPulse[j];
+			wheel_config.wheels[i].calibration.velocity[j] = snapshot.wheels[i].calibrationVelocity[j];
+		}
+	}
+	wheel_config.servoMin = snapshot.servoMin;
+	wheel_config.servoMax = snapshot.servoMax;
+	wheel_config.settleTime = snapshot.settleTime;
+	wheel_config.slideMode = snapshot.slideMode;
+	wheel_config.geometry = snapshot.geometry;
+	wheel_config.strafeTime = snapshot.strafeTime;
+	wheel_config.swapTurns = snapshot.swapTurns;
+	wheel_config.driftMode = snapshot.driftMode;
+	wheel_config.driftKp = snapshot.driftKp;
+	wheel_config.driftKi = snapshot.driftKi;
+	wheel_config.driftKd = snapshot.driftKd;
+	wheel_config.rampUpTime = snapshot.rampUpTime;
+	wheel_config.rampDownTime = snapshot.rampDownTime;
+	wheel_config.sensorInterval = snapshot.sensorInterval;
+	wheel_config.controlInterval = snapshot.controlInterval;
+	wheel_config.learnTiming = snapshot.learnTiming;
+	for (int i = 0; i < learnedMoves; i++) {
+		wheel_config.learnedTimes[i] = snapshot.learnedTimes[i];
+	}
+	wheel_config.traceRecords = snapshot.traceRecords;
+	RoboRuckusMovement::move_config.linearTime = snapshot.linearTime;
+	RoboRuckusMovement::move_config.linearDistance = snapshot.linearDistance;
+	RoboRuckusMovement::move_config.linearDrift = snapshot.linearDrift;
+	RoboRuckusMovement::move_config.turnTime = snapshot.turnTime;
+	RoboRuckusMovement::move_config.turnDistance = snapshot.turnDistance;
+	RoboRuckusMovement::move_config.turnDrift = snapshot.turnDrift;
+	RoboRuckusMovement::move_config.driftBoost = snapshot.driftBoost;
+	return true;
 }
 
-/// @brief Resets the wheels and sensor
-void RuckusServoWheels::resetMove() {
-	front_right.write(wheel_config.frontRightZero);
-	front_left.write(wheel_config.frontLeftZero);
-	if (four_wheels) {
-		rear_right.write(wheel_config.rearRightZero);
-		rear_left.write(wheel_config.rearLeftZero);
+/// @brief Calculates the CRC-32 (IEEE) of a block of memory
+/// @param data The data to check
+/// @param length The number of bytes to check
+/// @return The CRC
+uint32_t RuckusServoWheels::crc32(const uint8_t* data, size_t length) {
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
 	}
-	if (navSensor != nullptr) {
-		navSensor->endMove();
+	return ~crc;
+}
+
+/// @brief Converts a hex digit to its value
+/// @param digit The digit
+/// @return The value, or -1 if the character is not a hex digit
+int RuckusServoWheels::hexValue(char digit) {
+	if (digit >= '0' && digit <= '9') {
+		return digit - '0';
+	}
+	if (digit >= 'a' && digit <= 'f') {
+		return digit - 'a' + 10;
+	}
+	return -1;
+}
+
+/// @brief Gets diagnostic counters for the wheels
+/// @return A JSON string of the counters
+String RuckusServoWheels::getDiagnostics() {
+	JsonDocument doc;
+	doc["servoWrites"] = servo_writes;
+	doc["servoWritesSkipped"] = servo_writes_skipped;
+	String output;
+	serializeJson(doc, output);
+	return output;
+}
+
+/// @brief Gets measurements of the most recent moves, oldest first. With a control task running the move in progress is listed once it finishes
+/// @return A JSON string of the move telemetry
+String RuckusServoWheels::getTelemetry() {
+	static const char* const endNames[] = {"running", "time", "sensor", "stopped", "aborted"};
+	collectControlUpdates();
+	JsonDocument doc;
+	JsonArray moves = doc["moves"].to<JsonArray>();
+	auto addEntry = [&](const moveTelemetry& record, int ended) {
+		JsonObject entry = moves.add<JsonObject>();
+		entry["move"] = (int)record.move;
+		entry["magnitude"] = record.magnitude;
+		entry["start"] = record.startTime;
+		entry["end"] = record.endTime;
+		entry["iterations"] = record.iterations;
+		entry["tickMin"] = record.iterations > 1 ? record.tickMin : 0;
+		entry["tickMax"] = record.tickMax;
+		entry["tickMean"] = record.iterations > 1 ? record.tickTotal / (record.iterations - 1) : 0;
+		entry["sensorCalls"] = record.sensorCalls;
+		entry["sensorMean"] = record.sensorCalls > 0 ? record.sensorTotal / record.sensorCalls : 0;
+		entry["sensorMax"] = record.sensorMax;
+		entry["driftCorrections"] = record.driftCorrections;
+		entry["ended"] = endNames[ended];
 	};
-}
\ No newline at end of file
+	for (int i = 0; i < telemetry_count; i++) {
+		const moveTelemetry& record = move_telemetry[(telemetry_head - telemetry_count + i + telemetrySize) % telemetrySize];
+		addEntry(record, record.ended);
+	}
+	// The control task's record of the move in progress is its own until the move finishes
+	if (!control_task.running() && telemetry != nullptr) {
+		addEntry(*telemetry, END_NONE);
+	}
+	String output;
+	serializeJson(doc, output);
+	return output;
+}
+
+/// @brief Writes the move trace as binary, a traceHeader followed by the records oldest first. With a control task running, read it between moves as the task records during them
+/// @param output The stream to write to
+/// @return The number of bytes written
+size_t RuckusServoWheels::getTrace(Print& output) {
+	traceHeader header = {traceMagic, traceVersion, sizeof(traceRecord), (uint32_t)wheel_count, (uint32_t)trace_count};
+	size_t length = output.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+	for (int i = 0; i < trace_count; i++) {
+		const traceRecord& record = trace_buffer[(trace_head - trace_count + i + trace_size) % trace_size];
+		length += output.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+	}
+	return length;
+}
+
+/// @brief Empties the move trace, e.g. at the start of a game so the trace holds only that game's moves
+void RuckusServoWheels::clearTrace() {
+	trace_head = 0;
+	trace_count = 0;
+}
+
+/// @brief Gets the pose the wheels estimate from the speeds they were commanded, and when the current move is predicted to end, so the next move can be sent ahead of time
+/// @return A JSON string of the pose since the last resetOdometry() and the predicted time in ms until the move ends, -1 with no move running
+String RuckusServoWheels::getOdometry() {
+	JsonDocument doc;
+	doc["x"] = published_x.load(std::memory_order_relaxed);
+	doc["y"] = published_y.load(std::memory_order_relaxed);
+	doc["heading"] = published_heading.load(std::memory_order_relaxed);
+	doc["remaining"] = published_remaining.load(std::memory_order_relaxed);
+	String output;
+	serializeJson(doc, output);
+	return output;
+}
+
+/// @brief Gets the predicted time until the current move ends, from the nav sensor's measured speed where it reads the move and from the wheel speeds commanded otherwise
+/// @return Time in ms, for a slide the time until its current phase ends, -1 with no move running
+long RuckusServoWheels::remainingTime() {
+	return published_remaining.load(std::memory_order_relaxed);
+}
+
+/// @brief Restarts the odometry estimate from the robot's current pose, e.g. when it is placed on its starting square. With a control task running the task restarts it when it next updates the estimate
+void RuckusServoWheels::resetOdometry() {
+	if (control_task.running()) {
+		odometry_reset.store(true);
+		return;
+	}
+	odometry.x = 0;
+	odometry.y = 0;
+	odometry.heading = 0;
+	publishOdometry();
+}
+
+/// @brief Queues a move to run straight after the current one, consecutive moves of the same type are merged and others start without stopping the wheels
+/// @param move The type of move
+/// @param magnitude The magnitude of the move
+/// @return True if the move was queued, false if the queue is full or no move is running.
+/// A move sent to the control task just as the move it follows finishes is dropped by the task
+bool RuckusServoWheels::queueMove(RuckusCommunicator::MoveTypes move, int magnitude) {
+	if (control_task.running()) {
+		if (controlMoveDone()) {
+			return false;
+		}
+		// The control task owns the queue, count the moves still on their way to it. Taken is read first so the queue length is at least as new
+		uint32_t inFlight = queue_commands_sent - queue_commands_taken.load();
+		if (published_queue.load() + inFlight >= moveQueueSize || !control_commands.push({COMMAND_QUEUE, move, magnitude, move_generation}, commandReserve)) {
+			return false;
+		}
+		queue_commands_sent++;
+		return true;
+	}
+	// Queued while idle the move would be merged into whichever move starts next
+	if (!move_running) {
+		return false;
+	}
+	return addQueuedMove(move, magnitude);
+}
+
+/// @brief Adds a move to the end of the queue
+/// @param move The type of move
+/// @param magnitude The magnitude of the move
+/// @return True if the move was queued, false if the queue is full
+bool RuckusServoWheels::addQueuedMove(RuckusCommunicator::MoveTypes move, int magnitude) {
+	if (queue_count >= moveQueueSize) {
+		return false;
+	}
+	move_queue[(queue_head + queue_count) % moveQueueSize] = {move, magnitude};
+	queue_count++;
+	recordTrace(TRACE_QUEUE, move, magnitude);
+	return true;
+}
+
+/// @brief Gets the number of moves waiting in the queue
+/// @return The number of queued moves
+int RuckusServoWheels::queuedMoves() {
+	return control_task.running() ? published_queue.load() : queue_count;
+}
+
+/// @brief Starts calibrating the wheels with the nav sensor: finds each wheel's true zero, matches the left and right wheel speeds so the robot drives straight, then times a board square and a 90 degree turn.
+/// Call updateCalibration() from the loop until it returns false, a move or setConfig() cancels it. Needs clear space around the robot
+/// @return True if calibration started
+bool RuckusServoWheels::calibrate() {
+	if (navSensor == nullptr) {
+		Logger.println(F("Calibration needs a nav sensor"));
+		return false;
+	}
+	if (calibrating()) {
+		Logger.println(F("Already calibrating"));
+		return false;
+	}
+	if (control_task.running() ? !controlMoveDone() : move_running) {
+		Logger.println(F("Can't calibrate during a move"));
+		return false;
+	}
+	// Calibration drives the wheels itself, the task is started again when the results are applied
+	control_task.stop();
+	collectControlUpdates();
+	finishMove();
+	for (int i = 0; i < wheel_count; i++) {
+		for (int j = 0; j < 3; j++) {
+			calibration.speeds[i][j] = wheel_config.wheels[i].speed[j];
+		}
+	}
+	calibration.stage = CALIBRATION_STARTING;
+	calibration.wheel = 0;
+	calibration.runs = 0;
+	// Let the robot come to rest first
+	calibration.run = RUN_SETTLE;
+	calibration.runStart = millis();
+	return true;
+}
+
+/// @brief Steps a calibration started by calibrate(), call it from the loop
+/// @return True while calibrating
+bool RuckusServoWheels::updateCalibration() {
+	if (!calibrating()) {
+		return false;
+	}
+	if (calibration.run == RUN_SETTLE) {
+		if (millis() - calibration.runStart >= (unsigned long)wheel_config.settleTime) {
+			calibration.run = RUN_NONE;
+			nextCalibrationRun();
+		}
+	} else if (checkCalibrationRun()) {
+		calibration.runs++;
+		// Stop the wheels and the sensor and let the robot come to rest before the next drive
+		resetMove();
+		calibration.run = RUN_SETTLE;
+		calibration.runStart = millis();
+	}
+	return calibrating();
+}
+
+/// @brief Gets the progress of the last calibration started by calibrate()
+/// @return A JSON string of the stage: starting, zero, match or time while calibrating, then saved, failed or cancelled. With the wheel being zeroed and the number of drives made
+String RuckusServoWheels::getCalibration() {
+	static const char* const stageNames[] = {"none", "starting", "zero", "match", "time", "saved", "failed", "cancelled"};
+	JsonDocument doc;
+	doc["stage"] = stageNames[calibration.stage];
+	doc["wheel"] = calibration.wheel;
+	doc["runs"] = calibration.runs;
+	String output;
+	serializeJson(doc, output);
+	return output;
+}
+
+/// @brief Starts a move, handing it to the control task if one is running
+void RuckusServoWheels::startMove() {
+	if (calibrating()) {
+		cancelCalibration();
+	}
+	collectControlUpdates();
+	if (timing_updates >= timingSaveInterval) {
+		saveLearnedTimes();
+	}
+	checkPendingSave();
+	if (control_task.running()) {
+		move_generation++;
+		move_done = false;
+		sendControlCommand({COMMAND_START, currentMove, currentMagnitude, move_generation});
+		return;
+	}
+	active_move = currentMove;
+	active_magnitude = currentMagnitude;
+	recordTrace(TRACE_START, active_move, active_magnitude, traceModes());
+	move_running = true;
+	beginMove();
+}
+
+/// @brief End movement, the control task stops the wheels on its next tick if one is running
+void RuckusServoWheels::endMove() {
+	if (control_task.running()) {
+		if (!move_done) {
+			sendControlCommand({COMMAND_ABORT, currentMove, 0, move_generation});
+			move_done = true;
+		}
+		return;
+	}
+	if (move_running) {
+		recordTrace(TRACE_STOP);
+		stopMove(END_STOPPED);
+	}
+}
+
+/// @brief Checks if a movement should stop
+/// @return True if the movement should stop, with a control task running once the task has finished the move
+bool RuckusServoWheels::shouldStop() {
+	bool done;
+	if (control_task.running()) {
+		done = controlMoveDone();
+	} else {
+		// An aborted move has already stopped
+		done = !move_running || checkMove();
+	}
+	if (done) {
+		// Save changes made during the move now it has finished
+		checkPendingSave();
+	}
+	return done;
+}
+
+/// @brief Adjusts the wheel speeds based on drift measurements, left to the control task if one is running
+void RuckusServoWheels::correctDrift() {
+	if (!control_task.running() && move_running) {
+		correctMove();
+	}
+}
+
+/// @brief Stops the running move within one control tick, wherever it is, dropping any queued moves. A slide is stopped mid phase
+/// @return How far the move had got in units of its magnitude, measured by the nav sensor where it reads the move and otherwise estimated from the time driven, -1 if no move was running
+float RuckusServoWheels::abortMove() {
+	if (control_task.running()) {
+		if (move_done) {
+			return -1;
+		}
+		sendControlCommand({COMMAND_ABORT, currentMove, 0, move_generation});
+		// The task stops the move on its next tick, or has just finished it
+		while (!controlMoveDone()) {
+			vTaskDelay(1);
+		}
+		return move_progress.load();
+	}
+	if (!move_running) {
+		return -1;
+	}
+	recordTrace(TRACE_ABORT);
+	stopMove(END_ABORTED);
+	return move_progress.load();
+}
+
+/// @brief Aborts the running move and starts another in its place straight away, the framework carries on with the new move as if it had started it
+/// @param move The type of move
+/// @param magnitude The magnitude of the move
+/// @return How far the aborted move had got, as returned by abortMove(). -1 if no move was running, in which case nothing is started
+float RuckusServoWheels::preemptMove(RuckusCommunicator::MoveTypes move, int magnitude) {
+	float progress = abortMove();
+	if (progress < 0) {
+		return -1;
+	}
+	currentMove = move;
+	currentMagnitude = magnitude;
+	startMove();
+	return progress;
+}
+
+/// @brief Collects moves finished by the control task
+/// @return True once the control task has finished the move the framework loop last started
+bool RuckusServoWheels::controlMoveDone() {
+	collectControlUpdates();
+	uint32_t generation;
+	while (!move_done && control_done.pop(generation)) {
+		move_done = generation == move_generation;
+	}
+	return move_done;
+}
+
+/// @brief Passes a START or ABORT command to the control task. Queued moves leave room for these, should the queue still be full this waits for the task to take a command rather than lose the move
+/// @param command The command
+void RuckusServoWheels::sendControlCommand(const controlCommand& command) {
+	if (control_commands.push(command)) {
+		return;
+	}
+	Logger.println(F("Control command queue full, waiting for the control task"));
+	while (!control_commands.push(command)) {
+		vTaskDelay(1);
+	}
+}
+
+/// @brief Collects the learned times and telemetry records the control task has passed to the framework loop
+void RuckusServoWheels::collectControlUpdates() {
+	learnedTime update;
+	while (learned_updates.pop(update)) {
+		wheel_config.learnedTimes[update.index] = update.time;
+		timing_updates++;
+	}
+	moveTelemetry record;
+	while (finished_telemetry.pop(record)) {
+		addTelemetry(record);
+	}
+	if (!control_task.running()) {
+		// A stopped task can't send what didn't fit, so take it directly
+		for (int i = 0; i < learnedMoves; i++) {
+			if (learned_unsent & (1 << i)) {
+				wheel_config.learnedTimes[i] = learned_times[i];
+				timing_updates++;
+			}
+		}
+		learned_unsent = 0;
+	}
+}
+
+/// @brief Tells the framework loop the control task has finished the current move, sent again on the next tick if control_done is full
+void RuckusServoWheels::signalDone() {
+	if (!control_done.push(control_generation)) {
+		// Only the latest generation matters to the loop
+		done_unsent = control_generation;
+	}
+}
+
+/// @brief Sends what didn't fit in the queues to the framework loop on an earlier tick
+void RuckusServoWheels::retryControlUpdates() {
+	if (done_unsent != 0 && control_done.push(done_unsent)) {
+		done_unsent = 0;
+	}
+	for (int i = 0; i < learnedMoves; i++) {
+		if ((learned_unsent & (1 << i)) && learned_updates.push({i, learned_times[i]})) {
+			learned_unsent &= ~(1 << i);
+		}
+	}
+}
+
+/// @brief Passes an updated learned move time to the framework loop, which saves it
+/// @param index The index of the learned time
+void RuckusServoWheels::publishLearnedTime(int index) {
+	if (!control_task.running()) {
+		wheel_config.learnedTimes[index] = learned_times[index];
+		timing_updates++;
+	} else if (!learned_updates.push({index, learned_times[index]})) {
+		learned_unsent |= 1 << index;
+	}
+}
+
+/// @brief Starts the control task if controlInterval is set
+void RuckusServoWheels::startControlTask() {
+	if (wheel_config.controlInterval > 0 && !control_task.start(controlTick, this, wheel_config.controlInterval)) {
+		Logger.println(F("Could not start the control task, running moves from the framework loop"));
+	}
+}
+
+/// @brief Entry point of the control task
+/// @param wheels The RuckusServoWheels
+void RuckusServoWheels::controlTick(void* wheels) {
+	static_cast<RuckusServoWheels*>(wheels)->runControlTick();
+}
+
+/// @brief One control tick on the control task: takes commands from the framework loop, then corrects drift and checks for the end of the move
+void RuckusServoWheels::runControlTick() {
+	retryControlUpdates();
+	controlCommand command;
+	uint32_t taken = 0;
+	while (control_commands.pop(command)) {
+		switch (command.type) {
+			case COMMAND_START:
+				active_move = command.move;
+				active_magnitude = command.magnitude;
+				control_generation = command.generation;
+				recordTrace(TRACE_START, active_move, active_magnitude, traceModes());
+				move_running = true;
+				beginMove();
+				break;
+			case COMMAND_QUEUE:
+				taken++;
+				// A move queued behind one that has already finished would otherwise run after the next move started
+				if (!move_running || command.generation != control_generation) {
+					Logger.println(F("Move queued after its move finished, move dropped"));
+				} else if (!addQueuedMove(command.move, command.magnitude)) {
+					Logger.println(F("Move queue full, move dropped"));
+				}
+				break;
+			case COMMAND_ABORT:
+				if (move_running && command.generation == control_generation) {
+					recordTrace(TRACE_ABORT);
+					stopMove(END_ABORTED);
+					signalDone();
+				}
+				break;
+		}
+	}
+	if (move_running) {
+		correctMove();
+		if (checkMove()) {
+			// Stop the wheels on this tick rather than whenever the framework loop next asks
+			stopMove(END_STOPPED);
+			signalDone();
+		}
+	}
+	// The queue length is published first, so a loop that sees the new count of taken moves sees the length that includes them
+	published_queue.store(queue_count);
+	if (taken > 0) {
+		queue_commands_taken.fetch_add(taken);
+	}
+}
+
+/// @brief Starts the current move
+void RuckusServoWheels::beginMove() {
+	if (navSensor != nullptr) {
+		navSensor->startMove(active_move);
+	}
+	moveStartTime = millis();
+	move_time_scale = 1;
+	// Phases of a slide move are recorded as part of the slide
+	if (!compoundMove) {
+		startTelemetry();
+	}
+	startSampling();
+	const moveVelocity* velocity = findVelocity(active_move);
+	if (velocity == nullptr) {
+		if (active_move == RuckusCommunicator::SLIDELEFT || active_move == RuckusCommunicator::SLIDERIGHT) {
+			compoundMove = true;
+			currentMoveState = START;
+		}
+		return;
+	}
+	float fractions[maxWheels];
+	mixWheels(*velocity, fractions);
+	float headroom = wheel_config.servoMax - wheel_config.servoMin;
+	if (calibrated) {
+		// Scale every wheel's share of the move by the highest velocity all wheels can reach at their configured speeds, so the wheels match
+		float full = INFINITY;
+		for (int i = 0; i < wheel_count; i++) {
+			if (fractions[i] != 0) {
+				float reach = velocityForPulse(i, wheel_config.wheels[i].speed[fractions[i] < 0 ? WHEEL_BACKWARD : WHEEL_FORWARD]);
+				full = min(full, fabsf(reach / fractions[i]));
+			}
+		}
+		for (int i = 0; i < wheel_count; i++) {
+			move_velocities[i] = fractions[i] * full;
+		}
+	}
+	for (int i = 0; i < wheel_count; i++) {
+		move_speeds[i] = calibrated ? pulseForVelocity(i, move_velocities[i]) : fractionToPulse(i, fractions[i]);
+		corrected_speeds[i] = move_speeds[i];
+		headroom = min(headroom, fabsf(move_speeds[i] - wheel_config.wheels[i].speed[WHEEL_STOP]));
+	}
+	profile_peak_velocity = 0;
+	ramp_scale = wheel_config.rampUpTime > 0 ? ramp_start : 1;
+	startOdometry(velocity);
+	setOdometryWheels(fractions);
+	writeWheels();
+	// Half the correction is applied to each side, so no wheel is ever slowed past its zero
+	drift_pid.reset();
+	drift_pid.setLimit(headroom * 2);
+}
+
+/// @brief Stops the wheels and clears the move state
+void RuckusServoWheels::finishMove() {
+	recordTrace(TRACE_END, active_move);
+	// The stopped wheels drive nothing, so the estimate is brought up to now first
+	updateOdometry();
+	odometry.velocity = nullptr;
+	published_remaining.store(-1, std::memory_order_relaxed);
+	finishTelemetry(END_STOPPED);
+	resetMove();
+	compoundMove = false;
+	currentMoveState = START;
+	queue_count = 0;
+	ramp_start = 0;
+	move_running = false;
+}
+
+/// @brief Records how far the running move got, then stops it
+/// @param ended How the move ended, kept in its telemetry unless checkForEnd() already recorded a reason
+void RuckusServoWheels::stopMove(int ended) {
+	move_progress.store(moveProgress());
+	finishTelemetry(ended);
+	finishMove();
+}
+
+/// @brief Checks if the current move has ended, starting the next queued move if there is one
+/// @return True if the movement should stop
+bool RuckusServoWheels::checkMove() {
+	bool done = false;
+	if (telemetry != nullptr) {
+		unsigned long now = micros();
+		if (telemetry->iterations > 0) {
+			unsigned long tick = now - telemetry->lastTick;
+			telemetry->tickMin = min(telemetry->tickMin, tick);
+			telemetry->tickMax = max(telemetry->tickMax, tick);
+			telemetry->tickTotal += tick;
+		}
+		telemetry->lastTick = now;
+		telemetry->iterations++;
+	}
+	if (!compoundMove) {
+		mergeQueuedMoves();
+		done = checkForEnd();
+	} else {
+		switch (currentMoveState) {
+			case START:
+				compoundMoveType = active_move;
+				compoundMoveMagnitude = active_magnitude;
+				startPhase(compoundMoveType == RuckusCommunicator::SLIDELEFT ? LEFT : RIGHT);
+				break;
+			case LEFT:
+				if (checkForEnd()) {
+					if (compoundMoveType == RuckusCommunicator::SLIDELEFT) {
+						continueSlide(SETTLE_FORWARD);
+					} else {
+						done = true;
+					}
+				}
+				break;
+			case RIGHT:
+				if (checkForEnd()) {
+					if (compoundMoveType == RuckusCommunicator::SLIDELEFT) {
+						done = true;
+					} else {
+						continueSlide(SETTLE_FORWARD);
+					}
+				}
+				break;
+			case FORWARD:
+				if (checkForEnd()) {
+					continueSlide(compoundMoveType == RuckusCommunicator::SLIDELEFT ? SETTLE_RIGHT : SETTLE_LEFT);
+				}
+				break;
+			case SETTLE_LEFT:
+			case SETTLE_RIGHT:
+			case SETTLE_FORWARD:
+				if (isSettled()) {
+					if (navSensor != nullptr) {
+						navSensor->endMove();
+					}
+					startPhase(currentMoveState == SETTLE_LEFT ? LEFT : (currentMoveState == SETTLE_RIGHT ? RIGHT : FORWARD));
+				}
+				break;
+		}
+	}
+	if (done) {
+		finishTelemetry(END_NONE);
+		if (startQueuedMove()) {
+			done = false;
+		}
+	}
+	return done;
+}
+
+/// @brief Sizes the trace buffer to traceRecords, emptying the trace if the size changed
+void RuckusServoWheels::resizeTrace() {
+	int size = max(wheel_config.traceRecords, 0);
+	if (size == trace_size) {
+		return;
+	}
+	trace_buffer.reset();
+	trace_size = 0;
+	clearTrace();
+	if (size == 0) {
+		return;
+	}
+	trace_buffer.reset(new (std::nothrow) traceRecord[size]);
+	if (!trace_buffer) {
+		Logger.println(F("Not enough memory for the move trace, tracing disabled"));
+		wheel_config.traceRecords = 0;
+		return;
+	}
+	trace_size = size;
+}
+
+/// @brief Adds an event to the move trace, overwriting the oldest record once the buffer is full. Does nothing unless tracing is enabled
+/// @param event One of traceEvent
+/// @param index Move type, direction or wheel, see traceRecord
+/// @param value Magnitude, distance, drift or pulse width, see traceRecord
+/// @param modes Nav sensor modes for TRACE_START
+void RuckusServoWheels::recordTrace(uint8_t event, uint8_t index, float value, uint16_t modes) {
+	if (trace_size == 0) {
+		return;
+	}
+	trace_buffer[trace_head] = {(uint32_t)micros(), event, index, modes, value};
+	trace_head = (trace_head + 1) % trace_size;
+	if (trace_count < trace_size) {
+		trace_count++;
+	}
+}
+
+/// @brief Packs the moves the nav sensor can measure into the bits of traceRecord::modes
+/// @return The modes, 0 without a sensor
+uint16_t RuckusServoWheels::traceModes() {
+	if (navSensor == nullptr) {
+		return 0;
+	}
+	return navSensor->movementModes.forward | navSensor->movementModes.backward << 1 | navSensor->movementModes.turnLeft << 2 |
+		navSensor->movementModes.turnRight << 3 | navSensor->driftModes.forward << 4 | navSensor->driftModes.backward << 5;
+}
+
+/// @brief Starts a telemetry record for the move being started
+void RuckusServoWheels::startTelemetry() {
+	telemetry = &current_telemetry;
+	*telemetry = {};
+	telemetry->move = active_move;
+	telemetry->magnitude = active_magnitude;
+	telemetry->startTime = moveStartTime;
+	telemetry->tickMin = ULONG_MAX;
+}
+
+/// @brief Closes the telemetry record of the move being executed
+/// @param ended How the move ended, END_NONE to keep the reason recorded by checkForEnd()
+void RuckusServoWheels::finishTelemetry(int ended) {
+	if (telemetry == nullptr) {
+		return;
+	}
+	telemetry->endTime = millis();
+	if (ended != END_NONE) {
+		telemetry->ended = ended;
+	}
+	if (!control_task.running()) {
+		addTelemetry(*telemetry);
+	} else if (!finished_telemetry.push(*telemetry)) {
+		Logger.println(F("Telemetry queue full, move record dropped"));
+	}
+	telemetry = nullptr;
+}
+
+/// @brief Adds a finished move to the telemetry buffer, overwriting the oldest record if the buffer is full
+/// @param record The move's record
+void RuckusServoWheels::addTelemetry(const moveTelemetry& record) {
+	move_telemetry[telemetry_head] = record;
+	telemetry_head = (telemetry_head + 1) % telemetrySize;
+	if (telemetry_count < telemetrySize) {
+		telemetry_count++;
+	}
+}
+
+/// @brief Records a nav sensor reading in the telemetry of the move being executed
+/// @param started Time in us the reading was requested
+void RuckusServoWheels::recordSensorCall(unsigned long started) {
+	if (telemetry == nullptr) {
+		return;
+	}
+	unsigned long latency = micros() - started;
+	telemetry->sensorCalls++;
+	telemetry->sensorTotal += latency;
+	telemetry->sensorMax = max(telemetry->sensorMax, latency);
+}
+
+/// @brief Clears the cached nav sensor reading and works out which readings the current move needs
+void RuckusServoWheels::startSampling() {
+	sensor_sample.readsDistance = false;
+	sensor_sample.readsDrift = false;
+	sensor_sample.taken = false;
+	sensor_sample.velocity = 0;
+	sensor_sample.distanceUsed = true;
+	sensor_sample.driftUsed = true;
+	if (navSensor == nullptr) {
+		return;
+	}
+	switch (active_move) {
+		case RuckusCommunicator::MoveTypes::FORWARD:
+			sensor_sample.readsDistance = navSensor->movementModes.forward;
+			sensor_sample.readsDrift = navSensor->driftModes.forward;
+			break;
+		case RuckusCommunicator::MoveTypes::BACKWARD:
+			sensor_sample.readsDistance = navSensor->movementModes.backward;
+			sensor_sample.readsDrift = navSensor->driftModes.backward;
+			break;
+		case RuckusCommunicator::MoveTypes::TURNLEFT:
+			sensor_sample.readsDistance = navSensor->movementModes.turnLeft;
+			break;
+		case RuckusCommunicator::MoveTypes::TURNRIGHT:
+			sensor_sample.readsDistance = navSensor->movementModes.turnRight;
+			break;
+	}
+}
+
+/// @brief Polls the nav sensor for every reading the current move needs, unless the cached reading can still be used
+/// @param used True if the caller has already used its value from the cached reading
+void RuckusServoWheels::refreshSample(bool used) {
+	unsigned long now = micros();
+	// An unused value was read this pass for the other caller, a used one is reused until the poll interval passes
+	if (sensor_sample.taken && (!used || now - sensor_sample.time < (unsigned long)wheel_config.sensorInterval * 1000)) {
+		return;
+	}
+	if (sensor_sample.readsDistance) {
+		std::tuple<RoboRuckusSensor::Direction, float> result = navSensor->checkDistance();
+		recordSensorCall(now);
+		float distance = std::get<1>(result);
+		recordTrace(TRACE_DISTANCE, std::get<0>(result), distance);
+		if (sensor_sample.taken && now > sensor_sample.time && std::get<0>(result) == sensor_sample.direction) {
+			float velocity = (distance - sensor_sample.distance) * 1000 / (now - sensor_sample.time);
+			sensor_sample.velocity = sensor_sample.velocity * 0.7 + velocity * 0.3;
+		}
+		sensor_sample.direction = std::get<0>(result);
+		sensor_sample.distance = distance;
+	}
+	if (sensor_sample.readsDrift) {
+		unsigned long started = micros();
+		std::tuple<RoboRuckusSensor::Direction, float> result = navSensor->checkDrift();
+		recordSensorCall(started);
+		recordTrace(TRACE_DRIFT, std::get<0>(result), std::get<1>(result));
+		sensor_sample.drift = std::get<0>(result);
+		sensor_sample.driftAmount = std::get<1>(result);
+	}
+	sensor_sample.taken = true;
+	sensor_sample.time = now;
+	sensor_sample.distanceUsed = false;
+	sensor_sample.driftUsed = false;
+}
+
+/// @brief Gets the distance covered by the current move, extrapolated from the last reading at the measured speed
+/// @param expected The direction the sensor should report for the current move
+/// @return The distance, or -1 if the sensor reports movement in another direction
+float RuckusServoWheels::sampleDistance(RoboRuckusSensor::Direction expected) {
+	refreshSample(sensor_sample.distanceUsed);
+	sensor_sample.distanceUsed = true;
+	if (sensor_sample.direction != expected) {
+		return -1;
+	}
+	return extrapolateDistance();
+}
+
+/// @brief Extrapolates the distance of the last reading to now at the measured speed, without polling the sensor
+/// @return The distance
+float RuckusServoWheels::extrapolateDistance() {
+	float distance = sensor_sample.distance;
+	if (sensor_sample.velocity > 0) {
+		distance += sensor_sample.velocity * (micros() - sensor_sample.time) / 1000;
+	}
+	return distance;
+}
+
+/// @brief Gets the drift of the current move from the last reading
+/// @return The drift direction and amount
+std::tuple<RoboRuckusSensor::Direction, float> RuckusServoWheels::sampleDrift() {
+	refreshSample(sensor_sample.driftUsed);
+	sensor_sample.driftUsed = true;
+	return std::make_tuple(sensor_sample.drift, sensor_sample.driftAmount);
+}
+
+/// @brief Extends the current basic move with any queued moves of the same type, the sensor keeps measuring from the start of the move so no distance is lost
+void RuckusServoWheels::mergeQueuedMoves() {
+	while (queue_count > 0 && move_queue[queue_head].move == active_move && findVelocity(active_move) != nullptr) {
+		active_magnitude += move_queue[queue_head].magnitude;
+		if (telemetry != nullptr) {
+			telemetry->magnitude = active_magnitude;
+		}
+		queue_head = (queue_head + 1) % moveQueueSize;
+		queue_count--;
+	}
+}
+
+/// @brief Starts the next queued move straight away, without stopping the wheels in between
+/// @return True if a queued move was started
+bool RuckusServoWheels::startQueuedMove() {
+	if (queue_count == 0) {
+		return false;
+	}
+	queuedMove next = move_queue[queue_head];
+	queue_head = (queue_head + 1) % moveQueueSize;
+	queue_count--;
+	if (navSensor != nullptr) {
+		navSensor->endMove();
+	}
+	compoundMove = false;
+	active_move = next.move;
+	active_magnitude = next.magnitude;
+	// Pick up from the speed the last move ramped down to
+	ramp_start = rampMinimum;
+	beginMove();
+	return true;
+}
+
+/// @brief Adjusts the wheel speeds based on drift measurements of the current move, if supported
+void RuckusServoWheels::correctMove() {
+	// Every control tick of a move starts here, whether run by the framework loop or the control task
+	recordTrace(TRACE_TICK);
+	// Wheels are stopped while a slide move settles between phases
+	if (compoundMove && currentMoveState >= SETTLE_LEFT) {
+		return;
+	}
+	if (sensor_sample.readsDrift) {
+		for (int i = 0; i < wheel_count; i++) {
+			corrected_speeds[i] = move_speeds[i];
+		}
+		std::tuple<RoboRuckusSensor::Direction, float> result =	sampleDrift();
+		RoboRuckusSensor::Direction drift = std::get<0>(result);
+		if (wheel_config.driftMode == DRIFT_PID) {
+			float error = drift == RoboRuckusSensor::LEFT ? std::get<1>(result) : (drift == RoboRuckusSensor::RIGHT ? -std::get<1>(result) : 0);
+			// A positive output speeds up the left wheels and slows the right, reversing swaps which side that is
+			float output = drift_pid.update(error, micros());
+			if (active_move == RuckusCommunicator::MoveTypes::BACKWARD) {
+				output = -output;
+			}
+			if (output != 0 && telemetry != nullptr) {
+				telemetry->driftCorrections++;
+			}
+			for (int i = 0; i < wheel_count; i++) {
+				corrected_speeds[i] = adjustSpeed(i, (i & 1) ? output / 2 : -output / 2);
+			}
+		} else if (std::get<1>(result) >= RoboRuckusMovement::move_config.linearDrift && (drift == RoboRuckusSensor::LEFT || drift == RoboRuckusSensor::RIGHT)) {
+			// Speed up the wheels on the side the robot is drifting towards, or the opposite side when reversing
+			int side = ((drift == RoboRuckusSensor::LEFT) == (active_move == RuckusCommunicator::MoveTypes::FORWARD)) ? 1 : 0;
+			if (telemetry != nullptr) {
+				telemetry->driftCorrections++;
+			}
+			for (int i = side; i < wheel_count; i += 2) {
+				corrected_speeds[i] = adjustSpeed(i, RoboRuckusMovement::move_config.driftBoost);
+			}
+		}
+		writeWheels();
+	}
+}
+
+/// @brief Custom function to check if a basic (not compound) move should end
+/// @return True if the move should stop
+bool RuckusServoWheels::checkForEnd() {
+	unsigned long timeMoving = millis() - moveStartTime;
+	int unitTime;
+	float unitDistance;
+	RoboRuckusSensor::Direction expected;
+	if (!moveUnits(unitTime, unitDistance, expected)) {
+		return false;
+	}
+	unsigned long moveTime = active_magnitude * unitTime * move_time_scale;
+	updateOdometry();
+	bool driven = endsOnDriven();
+	// A move driven to its end runs longer than moveTime when ramping or corrections slowed its wheels, but never past drivenTimeLimit times it
+	unsigned long timeLimit = driven ? moveTime * drivenTimeLimit : moveTime;
+	if (timeMoving >= timeLimit || (driven && odometry.progress >= moveTime)) {
+		if (telemetry != nullptr) {
+			telemetry->ended = END_TIME;
+		}
+		learnTime(timeMoving, unitTime);
+		return true;
+	}
+	float goal = unitDistance * active_magnitude;
+	float distance = -1;
+	if (sensor_sample.readsDistance) {
+		distance = sampleDistance(expected);
+		if (distance >= goal) {
+			if (telemetry != nullptr) {
+				telemetry->ended = END_SENSOR;
+			}
+			learnTime(timeMoving, unitTime);
+			return true;
+		}
+	}
+	updateProfile(timeMoving, moveTime, distance, goal);
+	float remaining = timeLimit - timeMoving;
+	if (distance >= 0 && sensor_sample.velocity > 0) {
+		remaining = min((goal - distance) / sensor_sample.velocity, remaining);
+	} else if (calibrated) {
+		remaining = min(predictRemaining(timeMoving, moveTime - odometry.progress), remaining);
+	}
+	published_remaining.store(lround(max(remaining, 0.0f)), std::memory_order_relaxed);
+	return false;
+}
+
+/// @brief Checks if the current move ends once its wheels have been driven through all of it rather than on the clock.
+/// Only when the nav sensor doesn't read the move and calibration tables give the speed each pulse width drives a wheel at
+/// @return True if the move ends on how far it has been driven
+bool RuckusServoWheels::endsOnDriven() {
+	return calibrated && !sensor_sample.readsDistance;
+}
+
+/// @brief Gets the time and distance of one unit of magnitude of the current basic move
+/// @param unitTime Receives the time in ms the move takes per unit
+/// @param unitDistance Receives the distance the nav sensor reports per unit
+/// @param expected Receives the direction the nav sensor should report
+/// @return False if the current move is not a basic move
+bool RuckusServoWheels::moveUnits(int& unitTime, float& unitDistance, RoboRuckusSensor::Direction& expected) {
+	switch (active_move) {
+		case RuckusCommunicator::MoveTypes::FORWARD:
+			unitTime = RoboRuckusMovement::move_config.linearTime;
+			unitDistance = RoboRuckusMovement::move_config.linearDistance;
+			expected = RoboRuckusSensor::FORWARD;
+			break;
+		case RuckusCommunicator::MoveTypes::BACKWARD:
+			unitTime = RoboRuckusMovement::move_config.linearTime;
+			unitDistance = RoboRuckusMovement::move_config.linearDistance;
+			expected = RoboRuckusSensor::BACKWARD;
+			break;
+		case RuckusCommunicator::MoveTypes::TURNRIGHT:
+			unitTime = RoboRuckusMovement::move_config.turnTime;
+			unitDistance = RoboRuckusMovement::move_config.turnDistance;
+			expected = RoboRuckusSensor::RIGHT;
+			break;
+		case RuckusCommunicator::MoveTypes::TURNLEFT:
+			unitTime = RoboRuckusMovement::move_config.turnTime;
+			unitDistance = RoboRuckusMovement::move_config.turnDistance;
+			expected = RoboRuckusSensor::LEFT;
+			break;
+		case RuckusCommunicator::MoveTypes::SLIDELEFT:
+			unitTime = wheel_config.strafeTime;
+			unitDistance = RoboRuckusMovement::move_config.linearDistance;
+			expected = RoboRuckusSensor::LEFT;
+			break;
+		case RuckusCommunicator::MoveTypes::SLIDERIGHT:
+			unitTime = wheel_config.strafeTime;
+			unitDistance = RoboRuckusMovement::move_config.linearDistance;
+			expected = RoboRuckusSensor::RIGHT;
+			break;
+		default:
+			return false;
+	}
+	int learned = learnedIndex(active_move);
+	if (learned >= 0 && learned_times[learned] > 0) {
+		if (sensor_sample.readsDistance) {
+			// Leave the sensor room to end a move that has slowed down, so the slower time can be learned
+			if (learned_times[learned] > unitTime) {
+				unitTime = lround(learned_times[learned] * (1 + timingOutlier));
+			}
+		} else {
+			// Moves the sensor can't end run for the time learned from moves it did
+			unitTime = lround(learned_times[learned]);
+		}
+	}
+	return true;
+}
+
+/// @brief Gets the index of a move's learned time
+/// @param move The move type
+/// @return The index into learnedTimes, -1 for slides
+int RuckusServoWheels::learnedIndex(RuckusCommunicator::MoveTypes move) {
+	switch (move) {
+		case RuckusCommunicator::MoveTypes::FORWARD:
+			return 0;
+		case RuckusCommunicator::MoveTypes::BACKWARD:
+			return 1;
+		case RuckusCommunicator::MoveTypes::TURNLEFT:
+			return 2;
+		case RuckusCommunicator::MoveTypes::TURNRIGHT:
+			return 3;
+		default:
+			return -1;
+	}
+}
+
+/// @brief Updates the learned time of the current move from the distance the nav sensor measured it cover, smoothing out noise and skipping outliers unless they persist
+/// @param timeMoving Time in ms the move took
+/// @param unitTime Configured time of the move per unit of magnitude, the starting point of the learned time
+void RuckusServoWheels::learnTime(unsigned long timeMoving, int unitTime) {
+	int index = learnedIndex(active_move);
+	// Slide phases are skipped as arcs and settling change their timing
+	if (wheel_config.learnTiming == 0 || !sensor_sample.readsDistance || compoundMove || index < 0) {
+		return;
+	}
+	// A move cut short by its time limit still gives its speed, unless it barely got going
+	float progress = moveProgress();
+	if (progress < active_magnitude * 0.5f) {
+		return;
+	}
+	float& learned = learned_times[index];
+	if (learned <= 0) {
+		learned = unitTime;
+	}
+	float measured = timeMoving / (progress * move_time_scale);
+	if (fabsf(measured - learned) > learned * timingOutlier) {
+		// A run of outliers on the same side means the robot really has changed, such as a fresh battery, so start again from the latest measurement
+		int side = measured > learned ? 1 : -1;
+		timing_outliers[index] = timing_outliers[index] * side > 0 ? timing_outliers[index] + side : side;
+		if (abs(timing_outliers[index]) < timingOutlierRun) {
+			return;
+		}
+		learned = measured;
+	} else {
+		learned += (measured - learned) * timingSmoothing;
+	}
+	timing_outliers[index] = 0;
+	publishLearnedTime(index);
+}
+
+/// @brief Queues the learned move times to be saved with the other config changes
+void RuckusServoWheels::saveLearnedTimes() {
+	for (int i = 0; i < learnedMoves; i++) {
+		if (wheel_config.learnedTimes[i] > 0) {
+			pending_config[learnedTimeNames[i]] = wheel_config.learnedTimes[i];
+		}
+	}
+	queueSave();
+	timing_updates = 0;
+}
+
+/// @brief Works out how far the current move has got from the last nav sensor reading, without polling the sensor, or if the sensor doesn't read the move from how far the wheels have been driven where they are calibrated and the time driven otherwise
+/// @return Progress in units of the move's magnitude, the turns of a slide count as none or all of it
+float RuckusServoWheels::moveProgress() {
+	if (compoundMove) {
+		switch (currentMoveState) {
+			case FORWARD:
+				break;
+			case LEFT:
+				return compoundMoveType == RuckusCommunicator::SLIDELEFT ? 0 : compoundMoveMagnitude;
+			case RIGHT:
+				return compoundMoveType == RuckusCommunicator::SLIDERIGHT ? 0 : compoundMoveMagnitude;
+			case SETTLE_LEFT:
+			case SETTLE_RIGHT:
+				return compoundMoveMagnitude;
+			default:
+				return 0;
+		}
+	}
+	int unitTime;
+	float unitDistance;
+	RoboRuckusSensor::Direction expected;
+	if (!moveUnits(unitTime, unitDistance, expected)) {
+		return 0;
+	}
+	float progress;
+	if (sensor_sample.readsDistance && sensor_sample.taken && sensor_sample.direction == expected) {
+		progress = extrapolateDistance() / unitDistance;
+	} else if (calibrated) {
+		updateOdometry();
+		progress = odometry.progress / (unitTime * move_time_scale);
+	} else {
+		progress = (millis() - moveStartTime) / (unitTime * move_time_scale);
+	}
+	return constrain(progress, 0.0f, (float)active_magnitude);
+}
+
+/// @brief Advances the motion profile, ramping the wheels up at the start of a move and down towards its end
+/// @param timeMoving Time in ms since the move started
+/// @param moveTime Time in ms at which the move ends if the sensor doesn't end it first
+/// @param distance Distance reported by the nav sensor, negative if there is no reading
+/// @param goal Distance at which the nav sensor ends the move
+void RuckusServoWheels::updateProfile(unsigned long timeMoving, unsigned long moveTime, float distance, float goal) {
+	if (wheel_config.rampUpTime <= 0 && wheel_config.rampDownTime <= 0) {
+		return;
+	}
+	float scale = 1;
+	if (wheel_config.rampUpTime > 0) {
+		scale = min(scale, ramp_start + (1 - ramp_start) * timeMoving / wheel_config.rampUpTime);
+	}
+	if (wheel_config.rampDownTime > 0) {
+		if (endsOnDriven()) {
+			// The move ends on how far the wheels have been driven rather than the clock, so ramp down on what is left of that, the same way as on the sensor's distance
+			float remaining = moveTime - odometry.progress;
+			scale = min(scale, max(rampMinimum, sqrtf(remaining * 2 / wheel_config.rampDownTime)));
+		} else {
+			scale = min(scale, (float)(moveTime - timeMoving) / wheel_config.rampDownTime);
+		}
+		if (distance >= 0) {
+			profile_peak_velocity = max(profile_peak_velocity, sensor_sample.velocity);
+			if (profile_peak_velocity > 0) {
+				// Decelerating linearly over rampDownTime covers half the distance of running at full speed for that time
+				float remaining = (goal - distance) / profile_peak_velocity;
+				scale = min(scale, max(rampMinimum, sqrtf(remaining * 2 / wheel_config.rampDownTime)));
+			}
+		}
+	}
+	// Another move follows straight on, so keep the wheels turning into it
+	if (queue_count > 0 || slideContinues()) {
+		scale = max(scale, rampMinimum);
+	}
+	ramp_scale = constrain(scale, 0.0f, 1.0f);
+	writeWheels();
+}
+
+/// @brief Predicts how long the wheels take to drive the rest of the current move when the sensor doesn't end it, following the motion profile of updateProfile()
+/// @param timeMoving Time in ms since the move started
+/// @param left Time in ms the rest of the move takes at its mixed speeds
+/// @return Predicted time in ms
+float RuckusServoWheels::predictRemaining(unsigned long timeMoving, float left) {
+	// Corrections speed up or slow the move on top of the profile, assume they hold for the rest of it. Barely moving wheels are too coarse to tell
+	float rate = ramp_scale >= rampMinimum ? alongMove(odometry.shares) / (odometry.nominal * ramp_scale) : 1;
+	if (rate <= 0) {
+		rate = 1;
+	}
+	float time = 0;
+	if (wheel_config.rampUpTime > 0 && timeMoving < (unsigned long)wheel_config.rampUpTime) {
+		// The ramp up is linear, so it covers the mean of its current and full speed
+		float rampTime = wheel_config.rampUpTime - timeMoving;
+		float scale = ramp_start + (1 - ramp_start) * timeMoving / wheel_config.rampUpTime;
+		time += rampTime;
+		left -= rampTime * (1 + scale) / 2;
+	}
+	left = max(left, 0.0f);
+	if (wheel_config.rampDownTime > 0) {
+		// The ramp down starts with half of rampDownTime left and slows as the square root of what is left, until it reaches rampMinimum
+		float rampStart = wheel_config.rampDownTime / 2.0f;
+		float rampEnd = rampMinimum * rampMinimum * rampStart;
+		if (left > rampStart) {
+			time += left - rampStart;
+			left = rampStart;
+		}
+		if (left > rampEnd) {
+			time += sqrtf(2.0f * wheel_config.rampDownTime) * (sqrtf(left) - sqrtf(rampEnd));
+			left = rampEnd;
+		}
+		time += left / rampMinimum;
+	} else {
+		time += left;
+	}
+	return time / rate;
+}
+
+/// @brief Starts estimating the current move, bringing the estimate of the last one up to now first
+/// @param velocity The body velocity of the move
+void RuckusServoWheels::startOdometry(const moveVelocity* velocity) {
+	updateOdometry();
+	odometry.velocity = velocity;
+	odometry.progress = 0;
+}
+
+/// @brief Advances the odometry estimate to now at the wheel speeds last written, then publishes it
+void RuckusServoWheels::updateOdometry() {
+	unsigned long now = millis();
+	unsigned long elapsed = now - odometry.time;
+	if (elapsed == 0) {
+		return;
+	}
+	odometry.time = now;
+	if (odometry_reset.load(std::memory_order_relaxed) && odometry_reset.exchange(false)) {
+		odometry.x = 0;
+		odometry.y = 0;
+		odometry.heading = 0;
+	}
+	float forward, lateral, turn;
+	bodySpeeds(odometry.shares, forward, lateral, turn);
+	float speed = forward * RoboRuckusMovement::move_config.linearDistance / max(RoboRuckusMovement::move_config.linearTime, 1);
+	float slide = lateral * RoboRuckusMovement::move_config.linearDistance / max(wheel_config.strafeTime, 1);
+	float turning = turn * RoboRuckusMovement::move_config.turnDistance / max(RoboRuckusMovement::move_config.turnTime, 1);
+	if (speed != 0 || slide != 0) {
+		// Drive along the heading halfway through the interval, which only needs working out again while the robot turns
+		float angle = (odometry.heading + turning * elapsed / 2) * HALF_PI / RoboRuckusMovement::move_config.turnDistance;
+		if (angle != odometry.angle) {
+			odometry.angle = angle;
+			odometry.cosine = cosf(angle);
+			odometry.sine = sinf(angle);
+		}
+		odometry.x += (speed * odometry.cosine - slide * odometry.sine) * elapsed;
+		odometry.y += (speed * odometry.sine + slide * odometry.cosine) * elapsed;
+	}
+	odometry.heading += turning * elapsed;
+	if (odometry.velocity != nullptr && odometry.nominal != 0) {
+		odometry.progress += alongMove(odometry.shares) / odometry.nominal * elapsed;
+	}
+	publishOdometry();
+}
+
+/// @brief Sets the share of full speed each wheel has in the current move, once its speeds are set
+/// @param fractions Each wheel's share of full speed as mixed
+void RuckusServoWheels::setOdometryWheels(const float fractions[maxWheels]) {
+	for (int i = 0; i < wheel_count; i++) {
+		odometry.fractions[i] = fractions[i];
+		odometry.pulses[i] = lround(move_speeds[i]);
+		// Other pulse widths count in proportion to the speed they drive the wheel at
+		float full = calibrated ? velocityForPulse(i, odometry.pulses[i]) : odometry.pulses[i] - wheel_config.wheels[i].speed[WHEEL_STOP];
+		odometry.gains[i] = full != 0 ? fractions[i] / full : 0;
+	}
+	odometry.nominal = alongMove(fractions);
+}
+
+/// @brief Works out the share of full speed a pulse width drives a wheel at in the current move, advancing the estimate at the last share first if it changes
+/// @param wheel The index of the wheel
+/// @param pulse The pulse width in us being written
+void RuckusServoWheels::setWheelShare(int wheel, int pulse) {
+	float share = 0;
+	if (odometry.velocity != nullptr) {
+		float zero = wheel_config.wheels[wheel].speed[WHEEL_STOP];
+		if (pulse == odometry.pulses[wheel]) {
+			share = odometry.fractions[wheel];
+		} else if (pulse != lround(zero)) {
+			share = (calibrated ? velocityForPulse(wheel, pulse) : pulse - zero) * odometry.gains[wheel];
+		}
+	}
+	if (share == odometry.shares[wheel]) {
+		return;
+	}
+	updateOdometry();
+	odometry.shares[wheel] = share;
+}
+
+/// @brief Works out the body velocity wheel shares drive the robot at, the inverse of mixWheels()
+/// @param shares Each wheel's share of full speed
+/// @param forward Receives the forward speed, the mean of the wheels
+/// @param lateral Receives the speed to the left, from the rollers of diagonal wheels pushing the same way
+/// @param turn Receives the counter-clockwise turning speed, half the difference of the sides
+void RuckusServoWheels::bodySpeeds(const float shares[maxWheels], float& forward, float& lateral, float& turn) {
+	float right = 0, left = 0;
+	for (int i = 0; i < wheel_count; i++) {
+		((i & 1) ? left : right) += shares[i];
+	}
+	forward = (right + left) / wheel_count;
+	turn = (right - left) / wheel_count;
+	lateral = canStrafe() ? (shares[0] - shares[1] - shares[2] + shares[3]) / 4 : 0;
+}
+
+/// @brief Gets how fast wheel shares drive the robot along the body velocity of the current move
+/// @param shares Each wheel's share of full speed
+/// @return The component of the body velocity along the move's, 0 with no move running
+float RuckusServoWheels::alongMove(const float shares[maxWheels]) {
+	if (odometry.velocity == nullptr) {
+		return 0;
+	}
+	float forward, lateral, turn;
+	bodySpeeds(shares, forward, lateral, turn);
+	return forward * odometry.velocity->forward + lateral * odometry.velocity->lateral + turn * odometry.velocity->turn;
+}
+
+/// @brief Publishes the pose of the odometry estimate for getOdometry()
+void RuckusServoWheels::publishOdometry() {
+	// Each value is read on its own, so they need no ordering
+	published_x.store(odometry.x, std::memory_order_relaxed);
+	published_y.store(odometry.y, std::memory_order_relaxed);
+	published_heading.store(odometry.heading, std::memory_order_relaxed);
+}
+
+/// @brief Writes a pulse width to a wheel's servo, skipping the PWM peripheral if the servo already holds that value
+/// @param wheel The index of the wheel
+/// @param pulse The pulse width in us
+void RuckusServoWheels::writeServo(int wheel, float pulse) {
+	int value = lround(pulse);
+	setWheelShare(wheel, value);
+	if (servo_values[wheel] == value) {
+		servo_writes_skipped++;
+		return;
+	}
+	servos[wheel].writeMicroseconds(value);
+	servo_values[wheel] = value;
+	servo_writes++;
+	recordTrace(TRACE_SERVO, wheel, value);
+}
+
+/// @brief Writes the drift corrected wheel speeds to the servos, scaled by the motion profile
+void RuckusServoWheels::writeWheels() {
+	for (int i = 0; i < wheel_count; i++) {
+		float zero = wheel_config.wheels[i].speed[WHEEL_STOP];
+		if (calibrated && ramp_scale < 1) {
+			// Scale the velocity rather than the pulse width, the response is far from linear
+			writeServo(i, pulseForVelocity(i, ramp_scale * velocityForPulse(i, corrected_speeds[i])));
+		} else {
+			writeServo(i, zero + ramp_scale * (corrected_speeds[i] - zero));
+		}
+	}
+}
+
+/// @brief Checks if the wheels can move the robot sideways
+/// @return True for four mecanum or omni wheels
+bool RuckusServoWheels::canStrafe() {
+	return wheel_count == 4 && wheel_config.geometry != GEOMETRY_TANK;
+}
+
+/// @brief Finds the body velocity of a basic move
+/// @param move The move to look up
+/// @return The body velocity, or nullptr if the move is not a basic move for these wheels
+const RuckusServoWheels::moveVelocity* RuckusServoWheels::findVelocity(RuckusCommunicator::MoveTypes move) {
+	if (!wheel_config.swapTurns && (move == RuckusCommunicator::MoveTypes::TURNLEFT || move == RuckusCommunicator::MoveTypes::TURNRIGHT)) {
+		// The firmware turns left with the right wheels backward, which is the table's clockwise turn
+		move = move == RuckusCommunicator::MoveTypes::TURNLEFT ? RuckusCommunicator::MoveTypes::TURNRIGHT : RuckusCommunicator::MoveTypes::TURNLEFT;
+	}
+	for (const moveVelocity& velocity : moveVelocities) {
+		if (velocity.move == move && (velocity.lateral == 0 || canStrafe())) {
+			return &velocity;
+		}
+	}
+	return nullptr;
+}
+
+/// @brief Kinematics mixer, works out the share of full speed each wheel needs to move the robot at a body velocity
+/// @param velocity The body velocity
+/// @param fractions Receives each wheel's fraction of full speed, positive drives the robot forward, scaled down together so none passes 1
+void RuckusServoWheels::mixWheels(const moveVelocity& velocity, float fractions[maxWheels]) {
+	float largest = 0;
+	for (int i = 0; i < wheel_count; i++) {
+		// Wheels alternate right and left
+		fractions[i] = velocity.forward + ((i & 1) ? -velocity.turn : velocity.turn);
+		if (wheel_config.geometry != GEOMETRY_TANK) {
+			// The rollers of the front right and rear left wheels push the robot left when driven forward, the other two push it right
+			fractions[i] += (i == 0 || i == 3) ? velocity.lateral : -velocity.lateral;
+		}
+		largest = max(largest, fabsf(fractions[i]));
+	}
+	if (largest > 1) {
+		for (int i = 0; i < wheel_count; i++) {
+			fractions[i] /= largest;
+		}
+	}
+}
+
+/// @brief Converts a wheel's fraction of full speed to a pulse width between its zero and its configured forward or backward speed
+/// @param wheel The index of the wheel
+/// @param fraction The fraction of full speed, positive drives the robot forward
+/// @return The pulse width in us
+float RuckusServoWheels::fractionToPulse(int wheel, float fraction) {
+	const wheelSettings& settings = wheel_config.wheels[wheel];
+	float full = settings.speed[fraction < 0 ? WHEEL_BACKWARD : WHEEL_FORWARD];
+	return settings.speed[WHEEL_STOP] + fabsf(fraction) * (full - settings.speed[WHEEL_STOP]);
+}
+
+/// @brief Stops all wheels
+void RuckusServoWheels::stopWheels() {
+	for (int i = 0; i < wheel_count; i++) {
+		writeServo(i, wheel_config.wheels[i].speed[WHEEL_STOP]);
+	}
+}
+
+/// @brief Resets the wheels and sensor
+void RuckusServoWheels::resetMove() {
+	stopWheels();
+	if (navSensor != nullptr) {
+		navSensor->endMove();
+	};
+}
+
+/// @brief Stops the wheels and waits, without blocking, for the robot to come to rest before the next phase of a slide move
+/// @param nextState The settle state naming the phase to start once settled
+void RuckusServoWheels::startSettle(compoundMoveState nextState) {
+	stopWheels();
+	settleStartTime = millis();
+	settleSampleTime = settleStartTime;
+	settleDistance = -1;
+	currentMoveState = nextState;
+}
+
+/// @brief Checks if a settling robot has come to rest
+/// @return True once the settle time has passed, or earlier if the nav sensor reports the robot has stopped
+bool RuckusServoWheels::isSettled() {
+	unsigned long now = millis();
+	if (now - settleStartTime >= wheel_config.settleTime) {
+		return true;
+	}
+	if (navSensor == nullptr || now - settleSampleTime < settleSampleInterval) {
+		return false;
+	}
+	// The sensor is still measuring the phase that just ended, so an unchanged reading means the robot has stopped
+	bool supported = false;
+	float unitDistance = RoboRuckusMovement::move_config.linearDistance;
+	switch (active_move) {
+		case RuckusCommunicator::MoveTypes::FORWARD:
+			supported = navSensor->movementModes.forward;
+			break;
+		case RuckusCommunicator::MoveTypes::TURNLEFT:
+			supported = navSensor->movementModes.turnLeft;
+			unitDistance = RoboRuckusMovement::move_config.turnDistance;
+			break;
+		case RuckusCommunicator::MoveTypes::TURNRIGHT:
+			supported = navSensor->movementModes.turnRight;
+			unitDistance = RoboRuckusMovement::move_config.turnDistance;
+			break;
+	}
+	if (!supported) {
+		return false;
+	}
+	settleSampleTime = now;
+	unsigned long started = micros();
+	std::tuple<RoboRuckusSensor::Direction, float> result = navSensor->checkDistance();
+	recordSensorCall(started);
+	recordTrace(TRACE_DISTANCE, std::get<0>(result), std::get<1>(result));
+	float distance = std::get<1>(result);
+	bool stopped = settleDistance >= 0 && fabs(distance - settleDistance) <= unitDistance * 0.002;
+	settleDistance = distance;
+	return stopped;
+}
+
+/// @brief Moves a slide move on to its next phase, once the robot has settled or straight away for arc slides
+/// @param settleState The settle state naming the next phase
+void RuckusServoWheels::continueSlide(compoundMoveState settleState) {
+	if (wheel_config.slideMode != SLIDE_ARC) {
+		startSettle(settleState);
+		return;
+	}
+	if (navSensor != nullptr) {
+		navSensor->endMove();
+	}
+	startPhase(settleState == SETTLE_LEFT ? LEFT : (settleState == SETTLE_RIGHT ? RIGHT : FORWARD));
+}
+
+/// @brief Checks if the current phase of an arc slide runs straight on into another
+/// @return True for every phase but the last of an arc slide
+bool RuckusServoWheels::slideContinues() {
+	if (!compoundMove || wheel_config.slideMode != SLIDE_ARC) {
+		return false;
+	}
+	return currentMoveState != (compoundMoveType == RuckusCommunicator::SLIDELEFT ? RIGHT : LEFT);
+}
+
+/// @brief Starts a phase of a slide move
+/// @param phase The phase to start (LEFT, RIGHT or FORWARD)
+void RuckusServoWheels::startPhase(compoundMoveState phase) {
+	bool arc = wheel_config.slideMode == SLIDE_ARC;
+	if (phase == FORWARD) {
+		active_move = RuckusCommunicator::FORWARD;
+		active_magnitude = compoundMoveMagnitude;
+	} else {
+		active_move = phase == LEFT ? RuckusCommunicator::TURNLEFT : RuckusCommunicator::TURNRIGHT;
+		active_magnitude = 1;
+	}
+	bool first = phase != FORWARD && (phase == LEFT) == (compoundMoveType == RuckusCommunicator::SLIDELEFT);
+	// Arc phases after the first start from the speed the last one left the wheels at
+	if (arc && !first) {
+		ramp_start = rampMinimum;
+	}
+	currentMoveState = phase;
+	beginMove();
+	// How fast an arc turns can only be predicted from calibration tables, without them the sensor has to end the turn or the robot pivots as in a settled slide
+	if (!arc || phase == FORWARD || !(calibrated || sensor_sample.readsDistance)) {
+		return;
+	}
+	// Slowing the reversing side of the first turn makes it sweep forward, slowing the forward side of the last makes it sweep back by the same amount,
+	// so the robot ends the slide level with where it started
+	int reversing = findVelocity(active_move)->turn > 0 ? 1 : 0;
+	for (int i = first ? reversing : 1 - reversing; i < wheel_count; i += 2) {
+		if (calibrated) {
+			move_velocities[i] *= slideArcRatio;
+			move_speeds[i] = pulseForVelocity(i, move_velocities[i]);
+		} else {
+			float zero = wheel_config.wheels[i].speed[WHEEL_STOP];
+			move_speeds[i] = zero + (move_speeds[i] - zero) * slideArcRatio;
+		}
+		corrected_speeds[i] = move_speeds[i];
+		odometry.fractions[i] *= slideArcRatio;
+	}
+	setOdometryWheels(odometry.fractions);
+	// The slower side turns the robot less quickly
+	move_time_scale = 2 / (1 + slideArcRatio);
+	writeWheels();
+}
+
+/// @brief Drives the wheels at their configured speeds for a basic move, used by calibration
+/// @param move The move type
+void RuckusServoWheels::driveWheels(RuckusCommunicator::MoveTypes move) {
+	const moveVelocity* velocity = findVelocity(move);
+	if (velocity == nullptr) {
+		return;
+	}
+	float fractions[maxWheels];
+	mixWheels(*velocity, fractions);
+	for (int i = 0; i < wheel_count; i++) {
+		writeServo(i, fractionToPulse(i, fractions[i]));
+	}
+}
+
+/// @brief Checks if a calibration is running
+/// @return True from calibrate() until the results are saved, or calibration fails or is cancelled
+bool RuckusServoWheels::calibrating() {
+	return calibration.stage >= CALIBRATION_STARTING && calibration.stage <= CALIBRATION_TIME;
+}
+
+/// @brief Stops a running calibration and puts back the wheel speeds it started from
+void RuckusServoWheels::cancelCalibration() {
+	Logger.println(F("Calibration cancelled"));
+	resetMove();
+	for (int i = 0; i < wheel_count; i++) {
+		for (int j = 0; j < 3; j++) {
+			wheel_config.wheels[i].speed[j] = calibration.speeds[i][j];
+		}
+	}
+	calibration.stage = CALIBRATION_CANCELLED;
+	calibration.run = RUN_NONE;
+	applyConfig();
+	startControlTask();
+}
+
+/// @brief Starts a calibration drive
+/// @param run One of calibrationRun
+/// @param move The move driven, or the move the nav sensor measures for a single wheel probe
+/// @param pulse The pulse width in us a probed wheel is driven at
+void RuckusServoWheels::startCalibrationRun(int run, RuckusCommunicator::MoveTypes move, float pulse) {
+	calibration.run = run;
+	calibration.move = move;
+	calibration.pulse = pulse;
+	calibration.runStart = millis();
+	calibration.lastPoll = calibration.runStart;
+	navSensor->startMove(move);
+	if (run == RUN_PROBE) {
+		writeServo(calibration.wheel, pulse);
+	} else {
+		driveWheels(move);
+	}
+}
+
+/// @brief Checks if the calibration drive has finished, and if so measures it
+/// @return True once finished, with the measurement in calibration.result
+bool RuckusServoWheels::checkCalibrationRun() {
+	unsigned long elapsed = millis() - calibration.runStart;
+	switch (calibration.run) {
+		case RUN_PROBE: {
+			if (elapsed < calibrationProbeTime) {
+				return false;
+			}
+			std::tuple<RoboRuckusSensor::Direction, float> turned = navSensor->checkDistance();
+			calibration.result = std::get<0>(turned) == RoboRuckusSensor::RIGHT ? -std::get<1>(turned) : std::get<1>(turned);
+			return true;
+		}
+		case RUN_DRIFT: {
+			if (elapsed < calibrationRunTime) {
+				return false;
+			}
+			std::tuple<RoboRuckusSensor::Direction, float> drift = navSensor->checkDrift();
+			calibration.result = std::get<0>(drift) == RoboRuckusSensor::RIGHT ? -std::get<1>(drift) : std::get<1>(drift);
+			return true;
+		}
+		case RUN_TIME: {
+			unsigned long now = millis();
+			if (now - calibration.lastPoll < (unsigned long)max(wheel_config.sensorInterval, 1)) {
+				return false;
+			}
+			calibration.lastPoll = now;
+			bool linear = calibration.move == RuckusCommunicator::MoveTypes::FORWARD || calibration.move == RuckusCommunicator::MoveTypes::BACKWARD;
+			float goal = linear ? RoboRuckusMovement::move_config.linearDistance : RoboRuckusMovement::move_config.turnDistance;
+			if (std::get<1>(navSensor->checkDistance()) >= goal) {
+				calibration.result = elapsed;
+				return true;
+			}
+			// A move that never reaches the goal isn't timed
+			if (elapsed >= calibrationTimeout) {
+				calibration.result = 0;
+				return true;
+			}
+			return false;
+		}
+		default:
+			return true;
+	}
+}
+
+/// @brief Starts the next calibration drive once the last has settled, moving on through the stages as each finishes
+void RuckusServoWheels::nextCalibrationRun() {
+	switch (calibration.stage) {
+		case CALIBRATION_STARTING:
+			if (navSensor->movementModes.turnLeft && navSensor->movementModes.turnRight) {
+				calibration.stage = CALIBRATION_ZERO;
+				startZeroSearch();
+			} else {
+				Logger.println(F("Nav sensor can't measure turns, skipping wheel zeros"));
+				startSpeedMatch();
+			}
+			break;
+		case CALIBRATION_ZERO:
+			continueZeroSearch();
+			break;
+		case CALIBRATION_MATCH:
+			continueSpeedMatch();
+			break;
+		case CALIBRATION_TIME:
+			calibration.times[calibration.timeStep] = calibration.result;
+			calibration.timeStep++;
+			startTimedRun();
+			break;
+	}
+}
+
+/// @brief Starts the search for the current wheel's true zero, probing both ends of the search range
+void RuckusServoWheels::startZeroSearch() {
+	int wheel = calibration.wheel;
+	// A servo without pulses stops, so detaching the others keeps a wheel whose zero is still off from creeping during the search
+	for (int j = 0; j < wheel_count; j++) {
+		if (j != wheel) {
+			servos[j].detach();
+			attached_pins[j] = -1;
+		}
+	}
+	calibration.zero = wheel_config.wheels[wheel].speed[WHEEL_STOP];
+	calibration.low = calibration.zero - calibrationSearchRange;
+	calibration.high = calibration.zero + calibrationSearchRange;
+	calibration.zeroStep = ZERO_LOW;
+	startCalibrationRun(RUN_PROBE, RuckusCommunicator::MoveTypes::TURNLEFT, calibration.low);
+}
+
+/// @brief Takes the last probe of the current wheel and probes again, or finishes the wheel once its zero is found as the middle of its deadband.
+/// Bisects first for the highest pulse width still turning the robot like the low end of the range, then for the lowest turning it like the high end
+void RuckusServoWheels::continueZeroSearch() {
+	float turn = calibration.result;
+	switch (calibration.zeroStep) {
+		case ZERO_LOW:
+			calibration.lowTurn = turn;
+			calibration.zeroStep = ZERO_HIGH;
+			startCalibrationRun(RUN_PROBE, RuckusCommunicator::MoveTypes::TURNLEFT, calibration.high);
+			return;
+		case ZERO_HIGH:
+			calibration.highTurn = turn;
+			if (fabsf(calibration.lowTurn) < calibrationMotion || fabsf(turn) < calibrationMotion || (calibration.lowTurn < 0) == (turn < 0)) {
+				Logger.print(F("No zero found for wheel "));
+				Logger.println(wheelNames[calibration.wheel]);
+				finishZeroSearch();
+				return;
+			}
+			calibration.lowEdge = calibration.low;
+			calibration.above = calibration.high;
+			calibration.zeroStep = ZERO_LOW_EDGE;
+			break;
+		case ZERO_LOW_EDGE:
+			if (fabsf(turn) >= calibrationMotion && (turn < 0) == (calibration.lowTurn < 0)) {
+				calibration.lowEdge = calibration.pulse;
+			} else {
+				calibration.above = calibration.pulse;
+			}
+			break;
+		case ZERO_HIGH_EDGE:
+			if (fabsf(turn) >= calibrationMotion && (turn < 0) == (calibration.highTurn < 0)) {
+				calibration.highEdge = calibration.pulse;
+			} else {
+				calibration.below = calibration.pulse;
+			}
+			break;
+	}
+	if (calibration.zeroStep == ZERO_LOW_EDGE) {
+		if (calibration.above - calibration.lowEdge > calibrationResolution) {
+			startCalibrationRun(RUN_PROBE, RuckusCommunicator::MoveTypes::TURNLEFT, (calibration.lowEdge + calibration.above) / 2);
+			return;
+		}
+		calibration.below = calibration.lowEdge;
+		calibration.highEdge = calibration.high;
+		calibration.zeroStep = ZERO_HIGH_EDGE;
+	}
+	if (calibration.highEdge - calibration.below > calibrationResolution) {
+		startCalibrationRun(RUN_PROBE, RuckusCommunicator::MoveTypes::TURNLEFT, (calibration.below + calibration.highEdge) / 2);
+		return;
+	}
+	float found = roundf((calibration.lowEdge + calibration.highEdge) / 2);
+	float shift = found - calibration.zero;
+	wheelSettings& settings = wheel_config.wheels[calibration.wheel];
+	settings.speed[WHEEL_STOP] = found;
+	settings.speed[WHEEL_FORWARD] = constrain(settings.speed[WHEEL_FORWARD] + shift, (float)wheel_config.servoMin, (float)wheel_config.servoMax);
+	settings.speed[WHEEL_BACKWARD] = constrain(settings.speed[WHEEL_BACKWARD] + shift, (float)wheel_config.servoMin, (float)wheel_config.servoMax);
+	finishZeroSearch();
+}
+
+/// @brief Attaches all wheels again after a wheel's zero search, then searches for the next wheel's zero or moves on to matching speeds
+void RuckusServoWheels::finishZeroSearch() {
+	if (!applyConfig()) {
+		calibration.stage = CALIBRATION_FAILED;
+		startControlTask();
+		return;
+	}
+	calibration.wheel++;
+	if (calibration.wheel < wheel_count) {
+		startZeroSearch();
+	} else {
+		startSpeedMatch();
+	}
+}
+
+/// @brief Starts matching the wheel speeds, forward and backward runs alternate so the robot stays in place and the first pair finds the faster side
+void RuckusServoWheels::startSpeedMatch() {
+	if (!navSensor->driftModes.forward || !navSensor->driftModes.backward) {
+		Logger.println(F("Nav sensor can't measure drift, skipping speed matching"));
+		startTimedRuns();
+		return;
+	}
+	calibration.stage = CALIBRATION_MATCH;
+	for (int k = 0; k < 2; k++) {
+		for (int i = 0; i < wheel_count; i++) {
+			calibration.full[k][i] = wheel_config.wheels[i].speed[k == 0 ? WHEEL_FORWARD : WHEEL_BACKWARD];
+		}
+		calibration.fastSide[k] = -1;
+		calibration.scaleLow[k] = 0.5;
+		calibration.scaleHigh[k] = 1;
+	}
+	calibration.matchRun = 0;
+	calibration.matchDirection = 0;
+	calibration.measuring = false;
+	startDriftRun();
+}
+
+/// @brief Slows the faster side's speeds in a direction to a fraction of the speeds matching started from
+/// @param k The direction, 0 forward and 1 backward
+/// @param scale The fraction of its speed kept
+void RuckusServoWheels::scaleFastSide(int k, float scale) {
+	wheelDirection direction = k == 0 ? WHEEL_FORWARD : WHEEL_BACKWARD;
+	for (int i = calibration.fastSide[k]; i < wheel_count; i += 2) {
+		float zero = wheel_config.wheels[i].speed[WHEEL_STOP];
+		wheel_config.wheels[i].speed[direction] = roundf(zero + (calibration.full[k][i] - zero) * scale);
+	}
+}
+
+/// @brief Drives straight in the current direction at the middle of its bisection range to measure the drift
+void RuckusServoWheels::startDriftRun() {
+	int k = calibration.matchDirection;
+	calibration.scale = (calibration.scaleLow[k] + calibration.scaleHigh[k]) / 2;
+	if (calibration.matchRun > 0 && calibration.fastSide[k] >= 0) {
+		scaleFastSide(k, calibration.scale);
+	}
+	startCalibrationRun(RUN_DRIFT, k == 0 ? RuckusCommunicator::MoveTypes::FORWARD : RuckusCommunicator::MoveTypes::BACKWARD);
+}
+
+/// @brief Takes the drift of the last straight run, bisecting on the fraction of the faster side's speed kept until the runs stop drifting
+void RuckusServoWheels::continueSpeedMatch() {
+	int k = calibration.matchDirection;
+	float turn = calibration.result;
+	// Going backward a faster right side turns the robot clockwise
+	bool rightFaster = (turn > 0) == (k == 0);
+	if (fabsf(turn) < calibrationMotion) {
+		calibration.fastSide[k] = -1;
+	} else if (calibration.matchRun == 0) {
+		calibration.fastSide[k] = rightFaster ? 0 : 1;
+	} else if (calibration.fastSide[k] >= 0) {
+		if (rightFaster == (calibration.fastSide[k] == 0)) {
+			calibration.scaleHigh[k] = calibration.scale;
+		} else {
+			calibration.scaleLow[k] = calibration.scale;
+		}
+	}
+	calibration.measuring |= calibration.fastSide[k] >= 0;
+	if (++calibration.matchDirection < 2) {
+		startDriftRun();
+		return;
+	}
+	if (!calibration.measuring) {
+		startTimedRuns();
+		return;
+	}
+	calibration.matchDirection = 0;
+	calibration.measuring = false;
+	if (++calibration.matchRun <= calibrationMatchRuns) {
+		startDriftRun();
+		return;
+	}
+	for (k = 0; k < 2; k++) {
+		if (calibration.fastSide[k] >= 0) {
+			scaleFastSide(k, (calibration.scaleLow[k] + calibration.scaleHigh[k]) / 2);
+		}
+	}
+	startTimedRuns();
+}
+
+/// @brief Starts timing moves at full speed from a standstill, there and back so the robot ends up where it started
+void RuckusServoWheels::startTimedRuns() {
+	calibration.stage = CALIBRATION_TIME;
+	calibration.timeStep = 0;
+	for (int i = 0; i < 4; i++) {
+		calibration.times[i] = 0;
+	}
+	startTimedRun();
+}
+
+/// @brief Times the next move the nav sensor can measure, or saves the results once all are timed
+void RuckusServoWheels::startTimedRun() {
+	static const RuckusCommunicator::MoveTypes moves[4] = {RuckusCommunicator::MoveTypes::FORWARD, RuckusCommunicator::MoveTypes::BACKWARD,
+		RuckusCommunicator::MoveTypes::TURNLEFT, RuckusCommunicator::MoveTypes::TURNRIGHT};
+	bool linear = navSensor->movementModes.forward && navSensor->movementModes.backward;
+	bool turns = navSensor->movementModes.turnLeft && navSensor->movementModes.turnRight;
+	while (calibration.timeStep < 4 && !(calibration.timeStep < 2 ? linear : turns)) {
+		calibration.timeStep++;
+	}
+	if (calibration.timeStep < 4) {
+		startCalibrationRun(RUN_TIME, moves[calibration.timeStep]);
+		return;
+	}
+	finishCalibration();
+}
+
+/// @brief Applies and saves the calibrated speeds and times, times are rounded to the 10ms steps of the limits
+void RuckusServoWheels::finishCalibration() {
+	JsonDocument doc;
+	for (int i = 0; i < wheel_count; i++) {
+		String name = wheelNames[i];
+		for (int j = 0; j < 3; j++) {
+			doc[name + speedNames[j]] = wheel_config.wheels[i].speed[j];
+		}
+	}
+	const unsigned long* times = calibration.times;
+	if (times[0] > 0 && times[1] > 0) {
+		doc["linearTime"] = lround((times[0] + times[1]) / 20.0) * 10;
+	}
+	if (times[2] > 0 && times[3] > 0) {
+		doc["turnTime"] = lround((times[2] + times[3]) / 20.0) * 10;
+	}
+	String config;
+	serializeJson(doc, config);
+	// Marked saved first so setConfig() doesn't take it for a running calibration to cancel
+	calibration.stage = CALIBRATION_SAVED;
+	if (!setConfig(config, true) || !flushConfig()) {
+		calibration.stage = CALIBRATION_FAILED;
+	}
+}
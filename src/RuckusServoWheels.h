@@ -12,39 +12,218 @@
 #include <ArduinoJson.h>
 #include <RoboRuckusMovement.h>
 #include <ESP32Servo.h>
+#include <atomic>
+#include <memory>
+#include <new>
+#include "ControlTask.h"
+#include "PIDController.h"
+#include "SpscQueue.h"
 
 /// @brief Class for RoboRuckus bot movement via CR servos
 class RuckusServoWheels : public RoboRuckusMovement {
 	public:
 		RuckusServoWheels(String Name, int RightPin, int LeftPin, String ConfigFile = "RuckusServoWheels.json");
 		RuckusServoWheels(String Name, int RightFrontPin, int LeftFrontPin, int RightRearPin, int LeftRearPin, String ConfigFile = "RuckusServoWheels.json");
+		~RuckusServoWheels();
 		bool begin();
 		String getConfig();
+		size_t getConfig(Print& output);
 		bool setConfig(String config, bool save);
+		bool flushConfig();
+		String getDiagnostics();
+		String getTelemetry();
+		size_t getTrace(Print& output);
+		void clearTrace();
+		String getOdometry();
+		long remainingTime();
+		void resetOdometry();
+		bool queueMove(RuckusCommunicator::MoveTypes move, int magnitude);
+		int queuedMoves();
+		bool calibrate();
+		bool updateCalibration();
+		String getCalibration();
+		float abortMove();
+		float preemptMove(RuckusCommunicator::MoveTypes move, int magnitude);
 
 	protected:
-		/// @brief Stores if this device uses four wheels (two otherwise)
-		bool four_wheels = false;
-		
+		/// @brief Maximum number of wheels supported
+		static const int maxWheels = 4;
+
+		/// @brief Number of wheels in use, wheels alternate right and left: front right, front left, rear right, rear left
+		int wheel_count = 2;
+
+		/// @brief Config name prefix for each wheel
+		static const char* const wheelNames[maxWheels];
+
+		/// @brief Config name suffix for each wheel speed, indexed by wheelDirection
+		static const char* const speedNames[3];
+
+		/// @brief Basic moves whose time is learned from moves the nav sensor ends
+		static const int learnedMoves = 4;
+
+		/// @brief Config name of the learned time of each move, indexed by learnedIndex()
+		static const char* const learnedTimeNames[learnedMoves];
+
+		/// @brief Index into a wheel's speed table for each direction it can be driven
+		enum wheelDirection {WHEEL_BACKWARD, WHEEL_STOP, WHEEL_FORWARD};
+
+		/// @brief Maximum number of points in a wheel's calibration table
+		static const int calibrationPoints = 9;
+
+		/// @brief Measured wheel velocity at a set of pulse widths, sorted by pulse width
+		struct wheelCalibration {
+			/// @brief Number of points in use, fewer than 2 means the wheel is not calibrated
+			int points;
+
+			/// @brief Pulse widths in us
+			float pulse[calibrationPoints];
+
+			/// @brief Wheel velocity at each pulse width, positive drives the robot forward, in any unit shared by all wheels
+			float velocity[calibrationPoints];
+		};
+
+		/// @brief Settings for a single wheel
+		struct wheelSettings {
+			/// @brief Pin used by the wheel
+			int pin;
+
+			/// @brief Servo pulse widths in us indexed by wheelDirection: backward speed, zero position, forward speed
+			float speed[3];
+
+			/// @brief Maps pulse widths to wheel velocity, empty until the wheel is calibrated
+			wheelCalibration calibration;
+		};
+
+		/// @brief Layouts of wheels the kinematics mixer supports, omni wheels mix like mecanum wheels
+		enum wheelGeometries {GEOMETRY_TANK, GEOMETRY_MECANUM, GEOMETRY_OMNI};
+
+		/// @brief Body velocity of a basic move as fractions of full speed
+		struct moveVelocity {
+			RuckusCommunicator::MoveTypes move;
+			/// @brief Positive drives forward
+			float forward;
+			/// @brief Positive strafes left
+			float lateral;
+			/// @brief Positive turns counter-clockwise
+			float turn;
+		};
+
+		/// @brief Body velocity of each basic move, slides only where the wheels can strafe
+		static constexpr moveVelocity moveVelocities[] = {
+			{RuckusCommunicator::MoveTypes::FORWARD, 1, 0, 0},
+			{RuckusCommunicator::MoveTypes::BACKWARD, -1, 0, 0},
+			{RuckusCommunicator::MoveTypes::TURNLEFT, 0, 0, 1},
+			{RuckusCommunicator::MoveTypes::TURNRIGHT, 0, 0, -1},
+			{RuckusCommunicator::MoveTypes::SLIDELEFT, 0, 1, 0},
+			{RuckusCommunicator::MoveTypes::SLIDERIGHT, 0, -1, 0}
+		};
+
+		/// @brief Ways drift can be corrected, a fixed driftBoost or a PID controller
+		enum driftModes {DRIFT_BOOST, DRIFT_PID};
+
+		/// @brief Ways to slide, in phases with settling or as one continuous run with arcs
+		enum slideModes {SLIDE_TURNS, SLIDE_ARC};
+
+		/// @brief Speed of the inner wheel of a slide arc as a fraction of the outer wheel's, 1 would pivot in place
+		static constexpr float slideArcRatio = 0.75;
+
+		/// @brief Default drift correction in us, the base class default is in servo angle steps
+		static constexpr float defaultDriftBoost = 20;
+
 		/// @brief Stores path to settings file
 		String config_path;
 
+		/// @brief Stores path to the binary snapshot of the settings, loaded at boot in place of the JSON file
+		String snapshot_path;
+
+		/// @brief Stores path to the journal of config changes saved since the last compaction
+		String journal_path;
+
+		/// @brief Time in ms after a journal write during which further saved changes are batched
+		static const int saveDelay = 2000;
+
+		/// @brief Number of journal entries after which the journal is compacted into the JSON file and snapshot
+		static const int journalLimit = 16;
+
+		/// @brief Config changes waiting to be written to the journal
+		JsonDocument pending_config;
+
+		/// @brief True if pending_config holds changes not yet written
+		bool save_pending = false;
+
+		/// @brief Time of the last saved config change
+		unsigned long last_change_time = 0;
+
+		/// @brief Time of the last journal write
+		unsigned long last_save_time = 0;
+
+		/// @brief True once the journal has been written since boot
+		bool journal_written = false;
+
+		/// @brief Number of entries in the journal
+		int journal_entries = 0;
+
+		/// @brief Identifies a config snapshot file ("RSWC")
+		static const uint32_t snapshotMagic = 0x43575352;
+
+		/// @brief Layout version of configSnapshot, increment whenever its fields change
+		static const uint16_t snapshotVersion = 8;
+
+		/// @brief Fixed layout copy of wheel_config and move_config
+		struct configSnapshot {
+			uint32_t magic;
+			uint16_t version;
+			uint16_t size;
+			int32_t wheelCount;
+			char navSensor[32];
+			struct {
+				int32_t pin;
+				float speed[3];
+				int32_t calibrationCount;
+				float calibrationPulse[calibrationPoints];
+				float calibrationVelocity[calibrationPoints];
+			} wheels[maxWheels];
+			int32_t servoMin;
+			int32_t servoMax;
+			int32_t settleTime;
+			int32_t slideMode;
+			int32_t geometry;
+			int32_t strafeTime;
+			int32_t swapTurns;
+			int32_t driftMode;
+			float driftKp;
+			float driftKi;
+			float driftKd;
+			int32_t rampUpTime;
+			int32_t rampDownTime;
+			int32_t sensorInterval;
+			int32_t controlInterval;
+			int32_t learnTiming;
+			float learnedTimes[learnedMoves];
+			int32_t traceRecords;
+			int32_t linearTime;
+			float linearDistance;
+			float linearDrift;
+			int32_t turnTime;
+			float turnDistance;
+			float turnDrift;
+			float driftBoost;
+			/// @brief CRC-32 of every field above
+			uint32_t crc;
+		};
+
 		/// @brief Configuration for servo wheels
 		struct {
 			/// @brief Name of currently assigned navigation sensor
 			String navSensor = "None";
 
-			/// @brief Pins used by wheels
-			int frontRightPin, frontLeftPin, rearRightPin, rearLeftPin;
-
-			/// @brief Forward speeds of wheels
-			int frontRightForward = 15, frontLeftForward = 165, rearRightForward = 15, rearLeftForward = 165;
-
-			/// @brief Backward speeds of wheels
-			int frontRightBackward = 165, frontLeftBackward = 15, rearRightBackward = 165, rearLeftBackward = 15;
-
-			/// @brief Wheel zero positions
-			int frontRightZero = 90, frontLeftZero = 90, rearRightZero = 90, rearLeftZero = 90;
+			/// @brief Pins and speeds of each wheel
+			wheelSettings wheels[maxWheels] = {
+				{-1, {2245, 1472, 699}},
+				{-1, {699, 1472, 2245}},
+				{-1, {2245, 1472, 699}},
+				{-1, {699, 1472, 2245}}
+			};
 
 			/// @brief Minimum servo pulse
 			int servoMin = 544;
@@ -52,36 +231,263 @@ class RuckusServoWheels : public RoboRuckusMovement {
 			/// @brief Maximum servo pulse
 			int servoMax = 2400;
 
-			/// @brief JSON string that contains the upper and lower limits for settings, can be used to make sliders in interface
-			String limits = R"({
-				"frontRightForward": {"min": 0, "max": 180, "increment": 1},
-				"frontLeftForward": {"min": 0, "max": 180, "increment": 1},
-				"rearRightForward": {"min": 0, "max": 180, "increment": 1},
-				"rearLeftForward": {"min": 0, "max": 180, "increment": 1},
-				"frontRightBackward": {"min": 0, "max": 180, "increment": 1},
-				"frontLeftBackward": {"min": 0, "max": 180, "increment": 1},
-				"rearRightBackward": {"min": 0, "max": 180, "increment": 1},
-				"rearLeftBackward": {"min": 0, "max": 180, "increment": 1},
-				"frontRightZero": {"min": 80, "max": 100, "increment": 1},
-				"frontLeftZero": {"min": 80, "max": 100, "increment": 1},
-				"rearRightZero": {"min": 80, "max": 100, "increment": 1},
-				"rearLeftZero": {"min": 80, "max": 100, "increment": 1},
-				"linearTime": {"min": 500, "max": 2000, "increment": 10},
-				"turnTime": {"min": 250, "max": 2000, "increment": 10},
-				"driftBoost": {"min": 0, "max": 20, "increment": 1}
-			})";
+			/// @brief Time in ms to let the robot come to rest between the phases of a slide move
+			int settleTime = 250;
+
+			/// @brief How slide moves are driven, one of slideModes
+			int slideMode = SLIDE_TURNS;
+
+			/// @brief Layout of the wheels, one of wheelGeometries, four mecanum or omni wheels slide by strafing
+			int geometry = GEOMETRY_TANK;
+
+			/// @brief Time in ms to strafe one square
+			int strafeTime = 1300;
+
+			/// @brief 1 to swap the wheel directions of TURNLEFT and TURNRIGHT
+			int swapTurns = 0;
+
+			/// @brief How drift is corrected, one of driftModes
+			int driftMode = DRIFT_BOOST;
+
+			/// @brief Proportional gain of the PID drift controller (us of pulse width per unit of drift)
+			float driftKp = 100;
+
+			/// @brief Integral gain of the PID drift controller (per second)
+			float driftKi = 100;
+
+			/// @brief Derivative gain of the PID drift controller (seconds)
+			float driftKd = 0;
+
+			/// @brief Time in ms to ramp the wheels from stopped to full speed at the start of a move, 0 to disable
+			int rampUpTime = 0;
+
+			/// @brief Time in ms to ramp the wheels from full speed to stopped at the end of a move, 0 to disable
+			int rampDownTime = 0;
+
+			/// @brief Minimum time in ms between nav sensor readings during a move, 0 to read on every pass of the loop
+			int sensorInterval = 10;
+
+			/// @brief Time in ms between control ticks run on a dedicated task, 0 to run them from the framework loop
+			int controlInterval = 0;
+
+			/// @brief Set to 1 to learn the time of each basic move from moves the nav sensor ends, 0 to keep the learned times fixed
+			int learnTiming = 1;
+
+			/// @brief Learned time in ms per unit of magnitude of each basic move, 0 until learned
+			float learnedTimes[learnedMoves] = {0, 0, 0, 0};
+
+			/// @brief Number of records kept in the move trace, 0 to disable tracing
+			int traceRecords = 0;
 		} wheel_config;
 
+		/// @brief Upper and lower limits for settings as a JSON object, can be used to make sliders in interface
+		static constexpr char configLimits[] PROGMEM =
+			"{"
+			R"("frontRightForward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("frontLeftForward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("rearRightForward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("rearLeftForward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("frontRightBackward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("frontLeftBackward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("rearRightBackward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("rearLeftBackward": {"min": 500, "max": 2500, "increment": 1},)"
+			R"("frontRightZero": {"min": 1300, "max": 1650, "increment": 1},)"
+			R"("frontLeftZero": {"min": 1300, "max": 1650, "increment": 1},)"
+			R"("rearRightZero": {"min": 1300, "max": 1650, "increment": 1},)"
+			R"("rearLeftZero": {"min": 1300, "max": 1650, "increment": 1},)"
+			R"("linearTime": {"min": 500, "max": 2000, "increment": 10},)"
+			R"("turnTime": {"min": 250, "max": 2000, "increment": 10},)"
+			R"("driftBoost": {"min": 0, "max": 200, "increment": 1},)"
+			R"("settleTime": {"min": 0, "max": 1000, "increment": 10},)"
+			R"("slideMode": {"min": 0, "max": 1, "increment": 1},)"
+			R"("wheelGeometry": {"min": 0, "max": 2, "increment": 1},)"
+			R"("strafeTime": {"min": 500, "max": 3000, "increment": 10},)"
+			R"("swapTurns": {"min": 0, "max": 1, "increment": 1},)"
+			R"("driftMode": {"min": 0, "max": 1, "increment": 1},)"
+			R"("driftKp": {"min": 0, "max": 500, "increment": 5},)"
+			R"("driftKi": {"min": 0, "max": 500, "increment": 5},)"
+			R"("driftKd": {"min": 0, "max": 20, "increment": 0.1},)"
+			R"("rampUpTime": {"min": 0, "max": 1000, "increment": 10},)"
+			R"("rampDownTime": {"min": 0, "max": 1000, "increment": 10},)"
+			R"("sensorInterval": {"min": 0, "max": 100, "increment": 1},)"
+			R"("controlInterval": {"min": 0, "max": 20, "increment": 1},)"
+			R"("learnTiming": {"min": 0, "max": 1, "increment": 1},)"
+			R"("forwardTime": {"min": 0, "max": 3000, "increment": 1},)"
+			R"("backwardTime": {"min": 0, "max": 3000, "increment": 1},)"
+			R"("turnLeftTime": {"min": 0, "max": 3000, "increment": 1},)"
+			R"("turnRightTime": {"min": 0, "max": 3000, "increment": 1},)"
+			R"("traceRecords": {"min": 0, "max": 8192, "increment": 256})"
+			"}";
+
 		/// @brief Servos used by wheels
-		Servo front_right, front_left, rear_right, rear_left;
+		Servo servos[maxWheels];
+
+		/// @brief Pin each servo is attached to, -1 if not attached
+		int attached_pins[maxWheels] = {-1, -1, -1, -1};
+
+		/// @brief Pulse limits the servos are attached with
+		int attached_min = -1;
+		int attached_max = -1;
+
+		/// @brief Last pulse width in us written to each servo, -1 if the servo must be written next time regardless
+		int servo_values[maxWheels] = {-1, -1, -1, -1};
+
+		/// @brief Number of servo writes passed on to the PWM peripheral
+		unsigned long servo_writes = 0;
+
+		/// @brief Number of servo writes skipped because the servo already held the value
+		unsigned long servo_writes_skipped = 0;
+
+		/// @brief Pulse widths in us driving each wheel for the current move, before drift correction
+		float move_speeds[maxWheels];
+
+		/// @brief Pulse widths in us driving each wheel after drift correction, before the motion profile is applied
+		float corrected_speeds[maxWheels];
+
+		/// @brief Velocity each wheel is driven at for the current move before drift correction, used when all wheels are calibrated
+		float move_velocities[maxWheels];
+
+		/// @brief True if every wheel has a calibration table, so wheel commands are worked out from velocities
+		bool calibrated = false;
+
+		/// @brief Controller used to correct drift in DRIFT_PID mode
+		PIDController drift_pid;
+
+		/// @brief Fraction of full speed the motion profile currently allows
+		float ramp_scale = 1;
+
+		/// @brief Highest smoothed speed measured during the current move (distance per ms)
+		float profile_peak_velocity = 0;
+
+		/// @brief Multiplies the time limit of the current move, longer than 1 for the slower turns of slide arcs
+		float move_time_scale = 1;
+
+		/// @brief Fraction of full speed the motion profile ramps up from at the start of the current move
+		float ramp_start = 0;
+
+		/// @brief Lowest fraction of full speed used while ramping down on sensor distance
+		static constexpr float rampMinimum = 0.25;
+
+		/// @brief Multiple of a move's time after which a move ending on driven distance stops anyway
+		static const int drivenTimeLimit = 2;
+
+		/// @brief Weight of each new measurement in a learned move time
+		static constexpr float timingSmoothing = 0.2;
+
+		/// @brief Fraction a measured move time may differ from the learned time before it is treated as an outlier
+		static constexpr float timingOutlier = 0.25;
+
+		/// @brief Outliers in a row on one side after which the learned time is reset
+		static const int timingOutlierRun = 3;
+
+		/// @brief Number of learned time updates after which the learned times are saved
+		static const int timingSaveInterval = 8;
+
+		/// @brief Outliers in a row for each learned move time, positive above the learned time and negative below
+		int timing_outliers[learnedMoves] = {0, 0, 0, 0};
+
+		/// @brief Learned time updates since the learned times were last saved
+		int timing_updates = 0;
+
+		/// @brief Learned move times moves run on, owned by the control task when there is one
+		float learned_times[learnedMoves] = {0, 0, 0, 0};
+
+		/// @brief Distance in us either side of a wheel's zero searched for its true zero during calibration
+		static const int calibrationSearchRange = 150;
+
+		/// @brief Width in us at which the search for a wheel's true zero stops
+		static const int calibrationResolution = 2;
+
+		/// @brief Time in ms a single wheel is driven to test whether a pulse width moves it
+		static const int calibrationProbeTime = 300;
+
+		/// @brief Rotation in degrees reported by the nav sensor below which a wheel counts as stopped
+		static constexpr float calibrationMotion = 0.5;
+
+		/// @brief Time in ms of each straight run used to match the left and right wheel speeds
+		static const int calibrationRunTime = 1000;
+
+		/// @brief Maximum number of straight runs in each direction used to match the wheel speeds
+		static const int calibrationMatchRuns = 6;
+
+		/// @brief Longest a timed calibration move may take in ms before it is abandoned
+		static const int calibrationTimeout = 5000;
+
+		/// @brief Stages of a calibration started by calibrate(), STARTING waits for the robot to come to rest
+		enum calibrationStage {CALIBRATION_NONE, CALIBRATION_STARTING, CALIBRATION_ZERO, CALIBRATION_MATCH, CALIBRATION_TIME, CALIBRATION_SAVED, CALIBRATION_FAILED, CALIBRATION_CANCELLED};
+
+		/// @brief Drives made by a calibration, SETTLE waits for the robot to come to rest after one
+		enum calibrationRun {RUN_NONE, RUN_PROBE, RUN_DRIFT, RUN_TIME, RUN_SETTLE};
+
+		/// @brief Steps of the search for a wheel's true zero
+		enum zeroSearchStep {ZERO_LOW, ZERO_HIGH, ZERO_LOW_EDGE, ZERO_HIGH_EDGE};
+
+		/// @brief State of a calibration, stepped by updateCalibration()
+		struct {
+			/// @brief One of calibrationStage
+			int stage = CALIBRATION_NONE;
+
+			/// @brief Drive in progress, one of calibrationRun, and the time it or its settling started
+			int run = RUN_NONE;
+			unsigned long runStart = 0;
+
+			/// @brief Time of the last nav sensor reading of a timed drive
+			unsigned long lastPoll = 0;
+
+			/// @brief Move driven, and the wheel and pulse width of a probe
+			RuckusCommunicator::MoveTypes move = RuckusCommunicator::FORWARD;
+			int wheel = 0;
+			float pulse = 0;
+
+			/// @brief Measurement of the last drive, degrees counter-clockwise or ms
+			float result = 0;
+
+			/// @brief Number of drives made
+			int runs = 0;
+
+			/// @brief Wheel speeds calibration started from, put back if it is cancelled
+			float speeds[maxWheels][3];
+
+			/// @brief Zero search step, one of zeroSearchStep, and its range and bisection bounds
+			int zeroStep = ZERO_LOW;
+			float zero = 0;
+			float low = 0;
+			float high = 0;
+			float lowTurn = 0;
+			float highTurn = 0;
+			float lowEdge = 0;
+			float above = 0;
+			float below = 0;
+			float highEdge = 0;
+
+			/// @brief Speed matching run and direction, and whether any direction still drifts
+			int matchRun = 0;
+			int matchDirection = 0;
+			bool measuring = false;
+
+			/// @brief Starting speeds, side being slowed, bisection bounds and scale tried per direction
+			float full[2][maxWheels];
+			int fastSide[2] = {-1, -1};
+			float scaleLow[2] = {0.5, 0.5};
+			float scaleHigh[2] = {1, 1};
+			float scale = 1;
+
+			/// @brief Index of the move being timed and the times measured in ms
+			int timeStep = 0;
+			unsigned long times[4] = {0, 0, 0, 0};
+		} calibration;
 
 		void startMove();
 		void endMove();
 		bool shouldStop();
 		void correctDrift();
+		void beginMove();
+		void finishMove();
+		bool checkMove();
+		void correctMove();
 
-		/// @brief Possible states of a compound (slide) move
-		enum compoundMoveState {START, LEFT, RIGHT, FORWARD};
+		/// @brief Possible states of a compound (slide) move, SETTLE states wait for the robot to stop
+		enum compoundMoveState {START, LEFT, RIGHT, FORWARD, SETTLE_LEFT, SETTLE_RIGHT, SETTLE_FORWARD};
 
 		/// @brief True when the move being executed is a compound (slide) move
 		bool compoundMove = false;
@@ -95,6 +501,378 @@ class RuckusServoWheels : public RoboRuckusMovement {
 		/// @brief Stores the magnitude for compound (slide) moves
 		int compoundMoveMagnitude;
 
+		/// @brief Time the current settle state started
+		unsigned long settleStartTime = 0;
+
+		/// @brief Time of the last sensor reading taken while settling
+		unsigned long settleSampleTime = 0;
+
+		/// @brief Last sensor distance read while settling, negative if none taken yet
+		float settleDistance = -1;
+
+		/// @brief Minimum time in ms between sensor readings used to detect that the robot has stopped
+		static const int settleSampleInterval = 20;
+
+		/// @brief Maximum number of moves that can wait in the queue
+		static const int moveQueueSize = 8;
+
+		/// @brief A move waiting to be executed
+		struct queuedMove {
+			RuckusCommunicator::MoveTypes move;
+			int magnitude;
+		};
+
+		/// @brief Ring buffer of moves to run after the current one without stopping
+		queuedMove move_queue[moveQueueSize];
+
+		/// @brief Index of the next move in move_queue
+		int queue_head = 0;
+
+		/// @brief Number of moves in move_queue
+		int queue_count = 0;
+
+		/// @brief Runs the control tick at a fixed rate when controlInterval is set
+		ControlTask control_task;
+
+		/// @brief Commands passed from the framework loop to the control task
+		enum controlCommandType {COMMAND_START, COMMAND_QUEUE, COMMAND_ABORT};
+
+		/// @brief A command for the control task
+		struct controlCommand {
+			controlCommandType type;
+			RuckusCommunicator::MoveTypes move;
+			int magnitude;
+			/// @brief Identifies the move a START or ABORT command belongs to
+			uint32_t generation;
+		};
+
+		/// @brief Slots in control_commands queued moves leave free, so a START and an ABORT always fit
+		static const size_t commandReserve = 2;
+
+		/// @brief Commands from the framework loop, holds one less than its size
+		SpscQueue<controlCommand, moveQueueSize + commandReserve + 2> control_commands;
+
+		/// @brief Number of QUEUE commands the framework loop has sent, only used by the framework loop
+		uint32_t queue_commands_sent = 0;
+
+		/// @brief Number of QUEUE commands the control task has taken, published along with published_queue
+		std::atomic<uint32_t> queue_commands_taken {0};
+
+		/// @brief Generations of the moves the control task has finished, read by the framework loop
+		SpscQueue<uint32_t, 4> control_done;
+
+		/// @brief Generation of a finished move that didn't fit in control_done, sent again on the next tick, 0 if none
+		uint32_t done_unsent = 0;
+
+		/// @brief A learned move time passed from the control task to the framework loop
+		struct learnedTime {
+			int index;
+			float time;
+		};
+
+		/// @brief Learned move times updated by the control task, collected into wheel_config by the framework loop
+		SpscQueue<learnedTime, learnedMoves + 1> learned_updates;
+
+		/// @brief Bit for each learned time that didn't fit in learned_updates, sent again on the next tick
+		uint8_t learned_unsent = 0;
+
+		/// @brief Generation of the last move the framework loop started, only used by the framework loop
+		uint32_t move_generation = 0;
+
+		/// @brief True once the framework loop has seen the control task finish the current move
+		bool move_done = true;
+
+		/// @brief Generation of the move the control task is running, only used by the control task
+		uint32_t control_generation = 0;
+
+		/// @brief True from the start of a move until its wheels are stopped, only used by the control task when there is one
+		bool move_running = false;
+
+		/// @brief The move being executed and its magnitude, owned by the control task when there is one
+		RuckusCommunicator::MoveTypes active_move = RuckusCommunicator::FORWARD;
+		int active_magnitude = 0;
+
+		/// @brief Progress of the last move to stop in units of its magnitude, written by the control task when there is one
+		std::atomic<float> move_progress {0};
+
+		/// @brief Number of queued moves as last seen by the control task
+		std::atomic<int> published_queue {0};
+
+		/// @brief Last nav sensor reading of the current move, shared by checkForEnd() and correctMove()
+		struct {
+			/// @brief True if the sensor measures distance for the current move
+			bool readsDistance = false;
+
+			/// @brief True if the sensor measures drift for the current move
+			bool readsDrift = false;
+
+			/// @brief True once a reading has been taken during the current move
+			bool taken = false;
+
+			/// @brief Time of the reading in us
+			unsigned long time = 0;
+
+			/// @brief Direction and distance reported by checkDistance()
+			RoboRuckusSensor::Direction direction = RoboRuckusSensor::FORWARD;
+			float distance = 0;
+
+			/// @brief Direction and amount reported by checkDrift()
+			RoboRuckusSensor::Direction drift = RoboRuckusSensor::FORWARD;
+			float driftAmount = 0;
+
+			/// @brief Smoothed speed between readings (distance per ms), used to extrapolate between readings
+			float velocity = 0;
+
+			/// @brief Set once checkForEnd() or correctMove() has used the reading
+			bool distanceUsed = true;
+			bool driftUsed = true;
+		} sensor_sample;
+
+		/// @brief Dead reckoning from the wheel speeds commanded, only used by the control task when there is one
+		struct {
+			/// @brief Estimated pose since the last resetOdometry() in the nav sensor's units, x ahead, y left, heading counter-clockwise
+			float x = 0;
+			float y = 0;
+			float heading = 0;
+
+			/// @brief Heading in radians the robot was last advanced along, and its cosine and sine
+			float angle = 0;
+			float cosine = 1;
+			float sine = 0;
+
+			/// @brief Time in ms the estimate was last advanced to
+			unsigned long time = 0;
+
+			/// @brief Body velocity of the current move, nullptr between moves
+			const moveVelocity* velocity = nullptr;
+
+			/// @brief Each wheel's share of full speed in the current move as mixed, before ramping and correction
+			float fractions[maxWheels] = {0, 0, 0, 0};
+
+			/// @brief Each wheel's pulse width as mixed, and its share of full speed per us or unit of velocity
+			int pulses[maxWheels] = {0, 0, 0, 0};
+			float gains[maxWheels] = {0, 0, 0, 0};
+
+			/// @brief Each wheel's share of full speed as last written to its servo, positive drives the robot forward
+			float shares[maxWheels] = {0, 0, 0, 0};
+
+			/// @brief Speed of fractions along the current move
+			float nominal = 0;
+
+			/// @brief Time in ms the current move would have taken to get as far driving at its mixed speeds
+			float progress = 0;
+		} odometry;
+
+		/// @brief Pose of the odometry estimate as last published by the control task when there is one
+		std::atomic<float> published_x {0};
+		std::atomic<float> published_y {0};
+		std::atomic<float> published_heading {0};
+
+		/// @brief Predicted time in ms until the current move ends, -1 with no move running
+		std::atomic<long> published_remaining {-1};
+
+		/// @brief Set by resetOdometry() for the control task to clear the estimate
+		std::atomic<bool> odometry_reset {false};
+
+		/// @brief How a move ended
+		enum moveEnd {END_NONE, END_TIME, END_SENSOR, END_STOPPED, END_ABORTED};
+
+		/// @brief Measurements of one commanded move, times in us unless noted
+		struct moveTelemetry {
+			RuckusCommunicator::MoveTypes move;
+			int magnitude;
+			/// @brief Start and end of the move in ms
+			unsigned long startTime;
+			unsigned long endTime;
+			/// @brief Passes of the control loop
+			unsigned long iterations;
+			/// @brief Time between passes of the control loop
+			unsigned long tickMin;
+			unsigned long tickMax;
+			unsigned long tickTotal;
+			/// @brief Time of the last pass of the control loop
+			unsigned long lastTick;
+			/// @brief Nav sensor readings and the time spent waiting on them
+			unsigned long sensorCalls;
+			unsigned long sensorMax;
+			unsigned long sensorTotal;
+			/// @brief Passes of the control loop that applied a drift correction
+			unsigned long driftCorrections;
+			/// @brief How the move ended, one of moveEnd
+			int ended;
+		};
+
+		/// @brief Number of moves kept in the telemetry buffer
+		static const int telemetrySize = 16;
+
+		/// @brief Ring buffer of the most recent finished moves, only used by the framework loop
+		moveTelemetry move_telemetry[telemetrySize];
+
+		/// @brief Index the next move will be recorded at
+		int telemetry_head = 0;
+
+		/// @brief Number of moves in move_telemetry
+		int telemetry_count = 0;
+
+		/// @brief Record of the move being executed, nullptr if none
+		moveTelemetry* telemetry = nullptr;
+
+		/// @brief Storage for the record of the move being executed
+		moveTelemetry current_telemetry;
+
+		/// @brief Records of moves finished on the control task, collected into move_telemetry by the framework loop
+		SpscQueue<moveTelemetry, 4> finished_telemetry;
+
+		/// @brief Events in the move trace
+		enum traceEvent {TRACE_START, TRACE_QUEUE, TRACE_ABORT, TRACE_STOP, TRACE_TICK, TRACE_DISTANCE, TRACE_DRIFT, TRACE_SERVO, TRACE_END};
+
+		/// @brief One event in the move trace
+		struct traceRecord {
+			/// @brief Time of the event in us
+			uint32_t time;
+			/// @brief One of traceEvent
+			uint8_t event;
+			/// @brief Move type for START, QUEUE and END, direction for DISTANCE and DRIFT, wheel for SERVO
+			uint8_t index;
+			/// @brief Nav sensor modes for START, one bit per movement and drift mode
+			uint16_t modes;
+			/// @brief Magnitude for START and QUEUE, distance or drift for DISTANCE and DRIFT, pulse width in us for SERVO
+			float value;
+		};
+
+		/// @brief Identifies a move trace written by getTrace() ("RSWT")
+		static const uint32_t traceMagic = 0x54575352;
+
+		/// @brief Layout version of the move trace, increment whenever traceHeader or traceRecord change
+		static const uint16_t traceVersion = 1;
+
+		/// @brief Start of a move trace written by getTrace(), followed by the records oldest first
+		struct traceHeader {
+			uint32_t magic;
+			uint16_t version;
+			uint16_t recordSize;
+			uint32_t wheelCount;
+			uint32_t recordCount;
+		};
+
+		/// @brief Ring buffer of trace records, empty unless traceRecords is set
+		std::unique_ptr<traceRecord[]> trace_buffer;
+
+		/// @brief Number of records trace_buffer holds
+		int trace_size = 0;
+
+		/// @brief Index the next record will be written at
+		int trace_head = 0;
+
+		/// @brief Number of records in trace_buffer
+		int trace_count = 0;
+
+		void resizeTrace();
+		void recordTrace(uint8_t event, uint8_t index = 0, float value = 0, uint16_t modes = 0);
+		uint16_t traceModes();
+		void startTelemetry();
+		void finishTelemetry(int ended);
+		void addTelemetry(const moveTelemetry& record);
+		void recordSensorCall(unsigned long started);
+		void startSampling();
+		void refreshSample(bool used);
+		float sampleDistance(RoboRuckusSensor::Direction expected);
+		float extrapolateDistance();
+		std::tuple<RoboRuckusSensor::Direction, float> sampleDrift();
+		void mergeQueuedMoves();
+		bool startQueuedMove();
+		bool addQueuedMove(RuckusCommunicator::MoveTypes move, int magnitude);
+		void startControlTask();
+		static void controlTick(void* wheels);
+		void runControlTick();
 		bool checkForEnd();
+		bool moveUnits(int& unitTime, float& unitDistance, RoboRuckusSensor::Direction& expected);
+		bool endsOnDriven();
+		float moveProgress();
+		int learnedIndex(RuckusCommunicator::MoveTypes move);
+		void learnTime(unsigned long timeMoving, int unitTime);
+		void saveLearnedTimes();
+		void stopMove(int ended);
+		bool controlMoveDone();
+		void sendControlCommand(const controlCommand& command);
+		void collectControlUpdates();
+		void signalDone();
+		void retryControlUpdates();
+		void publishLearnedTime(int index);
+		void updateProfile(unsigned long timeMoving, unsigned long moveTime, float distance, float goal);
+		float predictRemaining(unsigned long timeMoving, float left);
+		void startOdometry(const moveVelocity* velocity);
+		void updateOdometry();
+		void setOdometryWheels(const float fractions[maxWheels]);
+		void setWheelShare(int wheel, int pulse);
+		void bodySpeeds(const float shares[maxWheels], float& forward, float& lateral, float& turn);
+		float alongMove(const float shares[maxWheels]);
+		void publishOdometry();
+		/// @brief Print that only counts what is written, used to size the config string before writing it
+		class ConfigCounter : public Print {
+			public:
+				size_t length = 0;
+				size_t write(uint8_t c) override { length++; return 1; }
+				size_t write(const uint8_t* buffer, size_t size) override { length += size; return size; }
+				using Print::write;
+		};
+
+		/// @brief Print that appends to a String
+		class ConfigWriter : public Print {
+			public:
+				ConfigWriter(String& Output) : output(Output) {}
+				size_t write(uint8_t c) override { output.concat((char)c); return 1; }
+				size_t write(const uint8_t* buffer, size_t size) override { output.concat((const char*)buffer, size); return size; }
+				using Print::write;
+
+			private:
+				String& output;
+		};
+
+		bool applyConfig();
+		bool queueSave();
+		void checkPendingSave();
+		bool compactConfig();
+		bool saveSnapshot();
+		bool loadSnapshot();
+		static uint32_t crc32(const uint8_t* data, size_t length);
+		static int hexValue(char digit);
+		static size_t printJsonKey(Print& output, const char* name, const char* suffix = "");
+		static size_t printJsonString(Print& output, const char* value);
+		static size_t printJsonFloat(Print& output, float value);
+		bool isDegreeConfig(JsonDocument& doc);
+		void loadCalibration(int wheel, JsonArray table);
+		float velocityForPulse(int wheel, float pulse);
+		float pulseForVelocity(int wheel, float velocity);
+		float adjustSpeed(int wheel, float change);
+		float degreesToPulse(float degrees);
+		void writeServo(int wheel, float pulse);
+		void writeWheels();
+		bool canStrafe();
+		const moveVelocity* findVelocity(RuckusCommunicator::MoveTypes move);
+		void mixWheels(const moveVelocity& velocity, float fractions[maxWheels]);
+		float fractionToPulse(int wheel, float fraction);
+		void stopWheels();
 		void resetMove();
+		void startSettle(compoundMoveState nextState);
+		bool isSettled();
+		void startPhase(compoundMoveState phase);
+		void continueSlide(compoundMoveState settleState);
+		bool slideContinues();
+		void driveWheels(RuckusCommunicator::MoveTypes move);
+		bool calibrating();
+		void cancelCalibration();
+		void startCalibrationRun(int run, RuckusCommunicator::MoveTypes move, float pulse = 0);
+		bool checkCalibrationRun();
+		void nextCalibrationRun();
+		void startZeroSearch();
+		void continueZeroSearch();
+		void finishZeroSearch();
+		void startSpeedMatch();
+		void scaleFastSide(int k, float scale);
+		void startDriftRun();
+		void continueSpeedMatch();
+		void startTimedRuns();
+		void startTimedRun();
+		void finishCalibration();
 };
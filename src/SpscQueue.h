@@ -0,0 +1,52 @@
+/*
+ * This file is licensed under the GPLv3 License Copyright (c) 2025 Sam Groveman
+ * 
+ * Contributors: Sam Groveman
+ */
+#pragma once
+#include <atomic>
+#include <stddef.h>
+
+/// @brief Lock-free ring buffer passing items from one producer task to one consumer task, holds Size - 1 items
+template <typename T, size_t Size>
+class SpscQueue {
+	public:
+		/// @brief Adds an item, only call from the producer
+		/// @param item The item to add
+		/// @param reserve Number of slots to leave free for later items
+		/// @return True on success, false if the queue is full
+		bool push(const T& item, size_t reserve = 0) {
+			size_t head = head_index.load(std::memory_order_relaxed);
+			size_t next = (head + 1) % Size;
+			// Slots free before this item, none when next reaches the tail
+			if ((tail_index.load(std::memory_order_acquire) + Size - next) % Size <= reserve) {
+				return false;
+			}
+			items[head] = item;
+			head_index.store(next, std::memory_order_release);
+			return true;
+		}
+
+		/// @brief Removes the oldest item, only call from the consumer
+		/// @param item Receives the item
+		/// @return True if an item was removed, false if the queue is empty
+		bool pop(T& item) {
+			size_t tail = tail_index.load(std::memory_order_relaxed);
+			if (tail == head_index.load(std::memory_order_acquire)) {
+				return false;
+			}
+			item = items[tail];
+			tail_index.store((tail + 1) % Size, std::memory_order_release);
+			return true;
+		}
+
+	protected:
+		/// @brief Storage for the items
+		T items[Size];
+
+		/// @brief Index the producer writes next
+		std::atomic<size_t> head_index {0};
+
+		/// @brief Index the consumer reads next
+		std::atomic<size_t> tail_index {0};
+};